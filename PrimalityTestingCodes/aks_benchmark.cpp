@@ -0,0 +1,77 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <gmp.h>
+#include <gmpxx.h>
+#include <fstream>
+#include <map>
+#include <vector>
+
+#include "primality/primality.h"
+
+int main() {
+    gmp_randstate_t rand_state;
+    gmp_randinit_mt(rand_state);
+    gmp_randseed_ui(rand_state, std::chrono::high_resolution_clock::now().time_since_epoch().count());
+
+    const std::vector<long long> digit_sizes = {5, 8, 10, 15, 20, 30, 40, 50};
+    // Sizes up to this many digits also get a complete aks_is_prime run
+    const long long full_run_digits = 8;
+    // Congruence checks timed per size; step 5 is projected from their average
+    const int sampled_checks = 3;
+    std::map<long long, double> setup_times;
+    std::map<long long, double> check_times;
+    std::map<long long, double> projected_times;
+
+    for (int digits : digit_sizes) {
+        mpz_class n;
+        generate_random_mpz(n.get_mpz_t(), rand_state, digits);
+        mpz_nextprime(n.get_mpz_t(), n.get_mpz_t());
+
+        // Steps 1-3 and phi(r), which fix the size of step 5
+        auto start_setup = std::chrono::high_resolution_clock::now();
+        is_perfect_power(n);
+        AksParameters params = select_aks_parameters(n);
+        auto end_setup = std::chrono::high_resolution_clock::now();
+        double setup = std::chrono::duration<double>(end_setup - start_setup).count();
+        unsigned long r = params.r;
+        unsigned long limit = params.limit;
+
+        auto start_check = std::chrono::high_resolution_clock::now();
+        for (int a = 1; a <= sampled_checks; ++a)
+            aks_congruence_holds(n, a, r);
+        auto end_check = std::chrono::high_resolution_clock::now();
+        double check = std::chrono::duration<double>(end_check - start_check).count() / sampled_checks;
+
+        std::cout << "Digits: " << digits << " (r = " << r << ", " << limit << " congruences)\n";
+        std::cout << "  Setup [steps 1-3, phi]    : " << setup << " seconds\n";
+        std::cout << "  Avg [one congruence]      : " << check << " seconds\n";
+        std::cout << "  Projected [full AKS]      : " << (setup + limit * check) << " seconds\n";
+        if (digits <= full_run_digits) {
+            auto start_full = std::chrono::high_resolution_clock::now();
+            bool prime = aks_is_prime(n);
+            auto end_full = std::chrono::high_resolution_clock::now();
+            std::cout << "  Measured [full AKS]       : " << std::chrono::duration<double>(end_full - start_full).count()
+                      << " seconds" << (prime ? "" : " (reported composite!)") << "\n";
+        }
+        std::cout << "\n";
+        setup_times[digits] = setup;
+        check_times[digits] = check;
+        projected_times[digits] = setup + limit * check;
+    }
+    // Print to file
+    std::ofstream file("Primality_Testing/data/aks_benchmark.csv");
+    if (file.is_open()) {
+        file << "Digits,Setup Time,Congruence Time,Projected Time\n";
+        for (const auto& size : digit_sizes) {
+            file << size << "," << setup_times[size] << "," << check_times[size] << "," << projected_times[size] << "\n";
+        }
+        file.close();
+    } else {
+        std::cerr << "Unable to open file for writing.\n";
+    }
+
+    gmp_randclear(rand_state);
+    return 0;
+}
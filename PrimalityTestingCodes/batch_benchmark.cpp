@@ -0,0 +1,82 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <gmp.h>
+#include <gmpxx.h>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "primality/primality.h"
+
+int main(int argc, char* argv[]) {
+    // Pass the largest thread count to try; defaults to every hardware thread
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+    if (argc > 1)
+        max_threads = std::stoul(argv[1]);
+
+    gmp_randstate_t rand_state;
+    gmp_randinit_mt(rand_state);
+    gmp_randseed_ui(rand_state, std::chrono::high_resolution_clock::now().time_since_epoch().count());
+
+    // The same mix of sizes the experiments sweep, shuffled together so the
+    // scheduler has to balance 100-digit and 1000-digit tests
+    const std::vector<long long> digit_sizes = {100, 200, 300, 400, 500, 600, 700, 800, 900, 1000};
+    const int per_size = 20;
+    std::vector<mpz_class> candidates;
+    for (int digits : digit_sizes) {
+        for (int t = 0; t < per_size; ++t) {
+            mpz_class n;
+            generate_random_mpz(n.get_mpz_t(), rand_state, digits);
+            // Primes, so every candidate runs all of its rounds
+            mpz_nextprime(n.get_mpz_t(), n.get_mpz_t());
+            candidates.push_back(n);
+        }
+    }
+    for (size_t i = candidates.size() - 1; i > 0; --i)
+        std::swap(candidates[i], candidates[gmp_urandomm_ui(rand_state, i + 1)]);
+
+    // Serial baseline on the calling thread
+    auto start_serial = std::chrono::high_resolution_clock::now();
+    for (const auto& n : candidates)
+        is_probable_prime(n.get_mpz_t());
+    auto end_serial = std::chrono::high_resolution_clock::now();
+    double serial = std::chrono::duration<double>(end_serial - start_serial).count();
+    std::cout << "Candidates: " << candidates.size() << "\n";
+    std::cout << "  Serial          : " << serial << " seconds\n";
+
+    std::ofstream file("Primality_Testing/data/batch_benchmark.csv");
+    if (file.is_open())
+        file << "Threads,Time,Speedup\n";
+    else
+        std::cerr << "Unable to open file for writing.\n";
+
+    // 1, 2, 4, ... threads, finishing on max_threads itself
+    std::vector<unsigned> thread_counts;
+    for (unsigned threads = 1; threads < max_threads; threads *= 2)
+        thread_counts.push_back(threads);
+    thread_counts.push_back(max_threads);
+
+    std::vector<PrimalityResult> results(candidates.size());
+    for (unsigned threads : thread_counts) {
+        ThreadPool pool(threads);
+        auto start = std::chrono::high_resolution_clock::now();
+        is_prime_batch(candidates, results, TestMode::Randomized, -1, &pool);
+        auto end = std::chrono::high_resolution_clock::now();
+        double total = std::chrono::duration<double>(end - start).count();
+
+        int composites = 0;
+        for (const auto& result : results)
+            composites += !result.prime;
+
+        std::cout << "  " << threads << " thread(s)" << std::string(threads < 10 ? 5 : 4, ' ') << ": " << total
+                  << " seconds, speedup " << (serial / total) << "x\n";
+        if (composites != 0)
+            std::cout << "  Primes reported composite: " << composites << "\n";
+        if (file.is_open())
+            file << threads << "," << total << "," << (serial / total) << "\n";
+    }
+
+    gmp_randclear(rand_state);
+    return 0;
+}
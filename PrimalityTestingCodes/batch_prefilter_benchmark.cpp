@@ -0,0 +1,83 @@
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <gmp.h>
+#include <gmpxx.h>
+#include <fstream>
+#include <vector>
+
+#include "primality/primality.h"
+
+int main() {
+    gmp_randstate_t rand_state;
+    gmp_randinit_mt(rand_state);
+    gmp_randseed_ui(rand_state, std::chrono::high_resolution_clock::now().time_since_epoch().count());
+
+    // The run_time_deviation workload: 1000 random candidates per size
+    const std::vector<long long> digit_sizes = {100, 300, 500, 1000};
+    const int num_candidates = 1000;
+    const std::vector<uint32_t> batch_limits = {1u << 14, 1u << 17, 1u << 20, 1u << 22};
+
+    std::ofstream file("Primality_Testing/data/batch_prefilter_benchmark.csv");
+    if (file.is_open())
+        file << "Digits,Screen,Prime Limit,Screen Time,Survivors,Total Time\n";
+    else
+        std::cerr << "Unable to open file for writing.\n";
+
+    MillerRabinContext context;
+    std::vector<int> verdicts(num_candidates);
+    for (int digits : digit_sizes) {
+        std::vector<mpz_class> candidates(num_candidates);
+        for (auto& n : candidates)
+            generate_random_mpz(n.get_mpz_t(), rand_state, digits);
+        int k = default_rounds(digits);
+        std::cout << "Digits: " << digits << " (" << num_candidates << " candidates)\n";
+
+        auto report = [&](const std::string& screen, uint32_t limit, double screen_time, int survivors, double total) {
+            std::cout << "  " << screen << " to " << limit << ": screen " << screen_time << " s, " << survivors
+                      << " survivors, with Miller-Rabin " << total << " s\n";
+            if (file.is_open())
+                file << digits << "," << screen << "," << limit << "," << screen_time << "," << survivors << ","
+                     << total << "\n";
+        };
+        // Miller-Rabin on the survivors only, with the per-candidate prefilter off
+        auto rounds_on_survivors = [&]() {
+            context.prefilter().set_limits(0, 0);
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < num_candidates; ++i)
+                if (verdicts[i] == -1)
+                    context.is_probable_prime(candidates[i].get_mpz_t(), k, thread_witness_source());
+            auto end = std::chrono::high_resolution_clock::now();
+            return std::chrono::duration<double>(end - start).count();
+        };
+
+        // Per candidate: Prefilter's default limits and its largest trial limit
+        for (uint32_t trial_limit : {Prefilter::default_trial_limit, small_prime_limit - 1}) {
+            Prefilter prefilter(Prefilter::default_gcd_limit, trial_limit);
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < num_candidates; ++i) {
+                mpz_srcptr n = candidates[i].get_mpz_t();
+                verdicts[i] = mpz_even_p(n) ? 0 : prefilter.screen(n);
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            double screen_time = std::chrono::duration<double>(end - start).count();
+            int survivors = std::count(verdicts.begin(), verdicts.end(), -1);
+            report("Per candidate", trial_limit, screen_time, survivors, screen_time + rounds_on_survivors());
+        }
+
+        for (uint32_t limit : batch_limits) {
+            BatchPrefilter batch(limit);
+            auto start = std::chrono::high_resolution_clock::now();
+            batch.screen(candidates, verdicts);
+            auto end = std::chrono::high_resolution_clock::now();
+            double screen_time = std::chrono::duration<double>(end - start).count();
+            int survivors = std::count(verdicts.begin(), verdicts.end(), -1);
+            report("Batch tree", limit, screen_time, survivors, screen_time + rounds_on_survivors());
+        }
+        std::cout << "\n";
+    }
+
+    gmp_randclear(rand_state);
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <gmp.h>
+#include <gmpxx.h>
+#include <fstream>
+#include <map>
+#include <vector>
+
+#include "primality/primality.h"
+
+int main() {
+    gmp_randstate_t rand_state;
+    gmp_randinit_mt(rand_state);
+    gmp_randseed_ui(rand_state, std::chrono::high_resolution_clock::now().time_since_epoch().count());
+
+    // Random primes; a certificate exists when N - 1 factors far enough
+    // within the budget, which gets rarer as N grows
+    const std::vector<long long> digit_sizes = {20, 30, 40, 60, 80, 100};
+    const int num_trials = 10;
+    FactorizationOptions options;
+    options.time_budget = 2.0;
+
+    std::map<long long, double> certify_times;
+    std::map<long long, double> verify_times;
+    std::map<long long, double> bpsw_times;
+    std::map<long long, double> success_rates;
+    std::map<long long, double> sizes;
+
+    for (int digits : digit_sizes) {
+        double total_certify = 0.0;
+        double total_verify = 0.0;
+        double total_bpsw = 0.0;
+        double total_size = 0.0;
+        int certified = 0;
+        int rejected = 0;
+
+        for (int t = 0; t < num_trials; ++t) {
+            mpz_class n;
+            generate_random_mpz(n.get_mpz_t(), rand_state, digits);
+            mpz_nextprime(n.get_mpz_t(), n.get_mpz_t());
+
+            auto start_bpsw = std::chrono::high_resolution_clock::now();
+            is_bpsw_prime(n.get_mpz_t());
+            auto end_bpsw = std::chrono::high_resolution_clock::now();
+            total_bpsw += std::chrono::duration<double>(end_bpsw - start_bpsw).count();
+
+            PrimalityCertificate certificate;
+            auto start_certify = std::chrono::high_resolution_clock::now();
+            bool found = certify_prime(n, certificate, options);
+            auto end_certify = std::chrono::high_resolution_clock::now();
+            total_certify += std::chrono::duration<double>(end_certify - start_certify).count();
+            if (!found)
+                continue;
+            ++certified;
+
+            // Verified from the text, as a recipient would
+            std::string text = certificate.serialize();
+            mpz_class prime;
+            auto start_verify = std::chrono::high_resolution_clock::now();
+            bool valid = verify_certificate(text, &prime);
+            auto end_verify = std::chrono::high_resolution_clock::now();
+            total_verify += std::chrono::duration<double>(end_verify - start_verify).count();
+            if (!valid || prime != n)
+                ++rejected;
+            total_size += text.size();
+        }
+
+        int divisor = certified > 0 ? certified : 1;
+        std::cout << "Digits: " << digits << "\n";
+        std::cout << "  Avg [Certify]         : " << (total_certify / num_trials) << " seconds\n";
+        std::cout << "  Avg [Verify]          : " << (total_verify / divisor) << " seconds\n";
+        std::cout << "  Avg [Baillie-PSW]     : " << (total_bpsw / num_trials) << " seconds\n";
+        std::cout << "  Avg certificate size  : " << (total_size / divisor) << " bytes\n";
+        std::cout << "  Certified             : " << certified << " / " << num_trials << " within "
+                  << options.time_budget << " s\n";
+        if (rejected != 0)
+            std::cout << "  Rejected certificates : " << rejected << "\n";
+        std::cout << "\n";
+        certify_times[digits] = total_certify / num_trials;
+        verify_times[digits] = total_verify / divisor;
+        bpsw_times[digits] = total_bpsw / num_trials;
+        sizes[digits] = total_size / divisor;
+        success_rates[digits] = static_cast<double>(certified) / num_trials;
+    }
+    // Print to file
+    std::ofstream file("Primality_Testing/data/certificate_benchmark.csv");
+    if (file.is_open()) {
+        file << "Digits,Certify Time,Verify Time,BPSW Time,Certificate Bytes,Success Rate\n";
+        for (const auto& size : digit_sizes) {
+            file << size << "," << certify_times[size] << "," << verify_times[size] << "," << bpsw_times[size] << ","
+                 << sizes[size] << "," << success_rates[size] << "\n";
+        }
+        file.close();
+    } else {
+        std::cerr << "Unable to open file for writing.\n";
+    }
+
+    gmp_randclear(rand_state);
+    return 0;
+}
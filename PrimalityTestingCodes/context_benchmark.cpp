@@ -0,0 +1,78 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <gmp.h>
+#include <fstream>
+#include <map>
+#include <vector>
+
+#include "primality/primality.h"
+
+int main() {
+    gmp_randstate_t rand_state;
+    gmp_randinit_mt(rand_state);
+    gmp_randseed_ui(rand_state, std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    MersenneTwisterSource witness_source(1);
+
+    const std::vector<long long> digit_sizes = {10, 20, 30, 40, 50, 60, 70, 80, 90, 100};
+    const int num_trials = 100000;
+    std::map<long long, double> fresh_times;
+    std::map<long long, double> reused_times;
+
+    MillerRabinContext reused;
+    reused.set_count_allocations(true);
+
+    for (int digits : digit_sizes) {
+        std::vector<mpz_class> candidates(num_trials);
+        for (auto& candidate : candidates) {
+            generate_random_mpz(candidate.get_mpz_t(), rand_state, digits);
+            mpz_setbit(candidate.get_mpz_t(), 0);  // odd, so every candidate reaches the rounds
+        }
+
+        // Fresh scratch for every call, as the per-call mpz_init/mpz_clear code did
+        unsigned long fresh_allocations = 0;
+        auto start_fresh = std::chrono::high_resolution_clock::now();
+        for (const auto& candidate : candidates) {
+            MillerRabinContext fresh;
+            fresh.set_count_allocations(true);
+            unsigned long before = gmp_allocation_count();
+            fresh.is_probable_prime(candidate.get_mpz_t(), -1, witness_source);
+            fresh_allocations += gmp_allocation_count() - before;
+        }
+        auto end_fresh = std::chrono::high_resolution_clock::now();
+
+        // One context reused across every call
+        unsigned long reused_allocations = 0;
+        auto start_reused = std::chrono::high_resolution_clock::now();
+        for (const auto& candidate : candidates) {
+            reused.is_probable_prime(candidate.get_mpz_t(), -1, witness_source);
+            reused_allocations += reused.last_allocations();
+        }
+        auto end_reused = std::chrono::high_resolution_clock::now();
+
+        double total_fresh = std::chrono::duration<double>(end_fresh - start_fresh).count();
+        double total_reused = std::chrono::duration<double>(end_reused - start_reused).count();
+
+        std::cout << "Digits: " << digits << "\n";
+        std::cout << "  Avg [Fresh scratch]   : " << (total_fresh / num_trials) << " seconds, "
+                  << (static_cast<double>(fresh_allocations) / num_trials) << " allocations per test\n";
+        std::cout << "  Avg [Reused context]  : " << (total_reused / num_trials) << " seconds, "
+                  << (static_cast<double>(reused_allocations) / num_trials) << " allocations per test\n\n";
+        fresh_times[digits] = total_fresh / num_trials;
+        reused_times[digits] = total_reused / num_trials;
+    }
+    // Print to file
+    std::ofstream file("Primality_Testing/data/miller_rabin_context.csv");
+    if (file.is_open()) {
+        file << "Digits,Fresh Time,Reused Time\n";
+        for (const auto& size : digit_sizes) {
+            file << size << "," << fresh_times[size] << "," << reused_times[size] << "\n";
+        }
+        file.close();
+    } else {
+        std::cerr << "Unable to open file for writing.\n";
+    }
+
+    gmp_randclear(rand_state);
+    return 0;
+}
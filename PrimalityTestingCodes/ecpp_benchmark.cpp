@@ -0,0 +1,125 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <gmp.h>
+#include <gmpxx.h>
+#include <fstream>
+#include <map>
+#include <vector>
+
+#include "primality/primality.h"
+
+int main() {
+    gmp_randstate_t rand_state;
+    gmp_randinit_mt(rand_state);
+    gmp_randseed_ui(rand_state, std::chrono::high_resolution_clock::now().time_since_epoch().count());
+
+    const std::vector<long long> digit_sizes = {100, 200, 300, 400, 500, 600, 700, 800, 900, 1000};
+    // One proof per size; once one misses the budget the larger sizes are skipped
+    EcppOptions options;
+    options.time_budget = 1800.0;
+    const int mr_trials = 10;
+    // AKS: one squaring in Z_n[x]/(x^r - 1) is timed up to this size and
+    // scaled by r * log2(n) beyond it; a full run costs limit * log2(n) of them
+    const long long aks_measured_digits = 200;
+
+    std::map<long long, double> ecpp_times;
+    std::map<long long, double> verify_times;
+    std::map<long long, double> mr_times;
+    std::map<long long, double> aks_times;
+    std::map<long long, size_t> steps;
+
+    double squaring_time = 0.0;
+    double squaring_size = 0.0;  // r * log2(n) of the timed squaring
+    bool skip = false;
+
+    for (int digits : digit_sizes) {
+        mpz_class n;
+        generate_random_mpz(n.get_mpz_t(), rand_state, digits);
+        mpz_nextprime(n.get_mpz_t(), n.get_mpz_t());
+        double bits = static_cast<double>(mpz_sizeinbase(n.get_mpz_t(), 2));
+
+        // Miller-Rabin with the default number of rounds, for scale
+        auto start_mr = std::chrono::high_resolution_clock::now();
+        for (int t = 0; t < mr_trials; ++t)
+            is_probable_prime(n.get_mpz_t());
+        auto end_mr = std::chrono::high_resolution_clock::now();
+        double mr = std::chrono::duration<double>(end_mr - start_mr).count() / mr_trials;
+
+        // AKS, projected from steps 1-3 and one squaring
+        auto start_setup = std::chrono::high_resolution_clock::now();
+        AksParameters params = select_aks_parameters(n);
+        auto end_setup = std::chrono::high_resolution_clock::now();
+        double setup = std::chrono::duration<double>(end_setup - start_setup).count();
+        double size = static_cast<double>(params.r) * bits;
+        if (digits <= aks_measured_digits) {
+            PolyModN poly(n, params.r);
+            poly.set_constant(1);
+            for (unsigned long a = 1; a <= 16; ++a)
+                poly.mul_x_plus_a(a);
+            auto start_sqr = std::chrono::high_resolution_clock::now();
+            poly.sqr();
+            auto end_sqr = std::chrono::high_resolution_clock::now();
+            squaring_time = std::chrono::duration<double>(end_sqr - start_sqr).count();
+            squaring_size = size;
+        }
+        double aks = setup + params.limit * bits * squaring_time * size / squaring_size;
+
+        std::cout << "Digits: " << digits << "\n";
+        std::cout << "  Avg [Miller-Rabin]      : " << mr << " seconds\n";
+        std::cout << "  Projected [AKS]         : " << aks << " seconds (r = " << params.r << ")\n";
+        mr_times[digits] = mr;
+        aks_times[digits] = aks;
+
+        if (skip) {
+            std::cout << "  [ECPP]                  : skipped\n\n";
+            continue;
+        }
+        PrimalityCertificate certificate;
+        auto start_ecpp = std::chrono::high_resolution_clock::now();
+        bool proven = ecpp_certify(n, certificate, options);
+        auto end_ecpp = std::chrono::high_resolution_clock::now();
+        double ecpp = std::chrono::duration<double>(end_ecpp - start_ecpp).count();
+        if (!proven) {
+            std::cout << "  [ECPP]                  : no certificate within " << options.time_budget << " s\n\n";
+            skip = true;
+            continue;
+        }
+
+        std::string text = certificate.serialize();
+        mpz_class prime;
+        auto start_verify = std::chrono::high_resolution_clock::now();
+        bool valid = verify_certificate(text, &prime);
+        auto end_verify = std::chrono::high_resolution_clock::now();
+        double verify = std::chrono::duration<double>(end_verify - start_verify).count();
+
+        std::cout << "  [ECPP certify]          : " << ecpp << " seconds, " << certificate.entries.size() << " steps, "
+                  << text.size() << " bytes\n";
+        std::cout << "  [Certificate check]     : " << verify << " seconds\n";
+        if (!valid || prime != n)
+            std::cout << "  Certificate rejected!\n";
+        std::cout << "\n";
+        ecpp_times[digits] = ecpp;
+        verify_times[digits] = verify;
+        steps[digits] = certificate.entries.size();
+    }
+    // Print to file; sizes ECPP did not reach are left blank
+    std::ofstream file("Primality_Testing/data/ecpp_benchmark.csv");
+    if (file.is_open()) {
+        file << "Digits,ECPP Time,Verify Time,Steps,MR Time,AKS Projected Time\n";
+        for (const auto& size : digit_sizes) {
+            file << size << ",";
+            if (ecpp_times.count(size))
+                file << ecpp_times[size] << "," << verify_times[size] << "," << steps[size];
+            else
+                file << ",,";
+            file << "," << mr_times[size] << "," << aks_times[size] << "\n";
+        }
+        file.close();
+    } else {
+        std::cerr << "Unable to open file for writing.\n";
+    }
+
+    gmp_randclear(rand_state);
+    return 0;
+}
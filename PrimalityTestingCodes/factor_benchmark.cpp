@@ -0,0 +1,90 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <gmp.h>
+#include <gmpxx.h>
+#include <fstream>
+#include <map>
+#include <vector>
+
+#include "primality/primality.h"
+
+int main() {
+    gmp_randstate_t rand_state;
+    gmp_randinit_mt(rand_state);
+    gmp_randseed_ui(rand_state, std::chrono::high_resolution_clock::now().time_since_epoch().count());
+
+    // n = p * q with p of the given size and q a 60-digit prime, so the
+    // cofactor is out of reach and only the small factor can be found
+    const std::vector<long long> factor_digits = {6, 9, 12, 15, 18, 21};
+    const int cofactor_digits = 60;
+    const int num_trials = 10;
+    FactorizationOptions options;
+    options.time_budget = 2.0;
+
+    std::map<long long, double> factor_times;
+    std::map<long long, double> success_rates;
+
+    for (int digits : factor_digits) {
+        double total = 0.0;
+        int found = 0;
+        int wrong = 0;
+
+        for (int t = 0; t < num_trials; ++t) {
+            mpz_class p, q;
+            generate_random_mpz(p.get_mpz_t(), rand_state, digits);
+            mpz_nextprime(p.get_mpz_t(), p.get_mpz_t());
+            generate_random_mpz(q.get_mpz_t(), rand_state, cofactor_digits);
+            mpz_nextprime(q.get_mpz_t(), q.get_mpz_t());
+            mpz_class n = p * q;
+
+            Factorization factors;
+            auto start = std::chrono::high_resolution_clock::now();
+            bool prime = is_probable_prime_or_factor(n.get_mpz_t(), factors, options);
+            auto end = std::chrono::high_resolution_clock::now();
+            total += std::chrono::duration<double>(end - start).count();
+
+            if (prime) {
+                ++wrong;
+                continue;
+            }
+            // Both primes found, or p found and q left over
+            bool has_p = false;
+            mpz_class product = 1;
+            for (const auto& [factor, exponent] : factors.primes) {
+                has_p |= factor == p;
+                product *= factor;
+            }
+            for (const auto& [part, exponent] : factors.composites)
+                product *= part;
+            if (product != n)
+                ++wrong;
+            else if (has_p)
+                ++found;
+        }
+
+        std::cout << "Factor digits: " << digits << " (cofactor " << cofactor_digits << " digits)\n";
+        std::cout << "  Avg [Test + factorize]: " << (total / num_trials) << " seconds\n";
+        std::cout << "  Factor found          : " << found << " / " << num_trials << " within "
+                  << options.time_budget << " s\n";
+        if (wrong != 0)
+            std::cout << "  Wrong results         : " << wrong << "\n";
+        std::cout << "\n";
+        factor_times[digits] = total / num_trials;
+        success_rates[digits] = static_cast<double>(found) / num_trials;
+    }
+    // Print to file
+    std::ofstream file("Primality_Testing/data/factor_benchmark.csv");
+    if (file.is_open()) {
+        file << "Factor Digits,Time,Success Rate\n";
+        for (const auto& size : factor_digits) {
+            file << size << "," << factor_times[size] << "," << success_rates[size] << "\n";
+        }
+        file.close();
+    } else {
+        std::cerr << "Unable to open file for writing.\n";
+    }
+
+    gmp_randclear(rand_state);
+    return 0;
+}
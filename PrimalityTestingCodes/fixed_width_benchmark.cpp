@@ -0,0 +1,77 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <gmp.h>
+#include <gmpxx.h>
+#include <fstream>
+#include <map>
+#include <vector>
+
+#include "primality/primality.h"
+
+int main() {
+    gmp_randstate_t rand_state;
+    gmp_randinit_mt(rand_state);
+    gmp_randseed_ui(rand_state, std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    MersenneTwisterSource witness_source(1);
+
+    const std::vector<long long> digit_sizes = {10, 12, 14, 16, 18, 19, 20, 24, 28, 32, 36, 38};
+    const int num_trials = 100000;
+    std::map<long long, double> gmp_path_times;
+    std::map<long long, double> native_times;
+
+    MillerRabinContext gmp_path, native;
+    gmp_path.set_fixed_width(false);
+
+    for (int digits : digit_sizes) {
+        std::vector<mpz_class> candidates(num_trials);
+        for (int t = 0; t < num_trials; ++t) {
+            generate_random_mpz(candidates[t].get_mpz_t(), rand_state, digits);
+            // Half primes so the full witness set is exercised
+            if (t % 2 == 0)
+                mpz_nextprime(candidates[t].get_mpz_t(), candidates[t].get_mpz_t());
+        }
+
+        int mismatches = 0;
+        std::vector<bool> verdicts(num_trials);
+
+        auto start_gmp = std::chrono::high_resolution_clock::now();
+        for (int t = 0; t < num_trials; ++t)
+            verdicts[t] = gmp_path.is_probable_prime(candidates[t].get_mpz_t(), -1, witness_source);
+        auto end_gmp = std::chrono::high_resolution_clock::now();
+
+        auto start_native = std::chrono::high_resolution_clock::now();
+        for (int t = 0; t < num_trials; ++t) {
+            if (native.is_probable_prime(candidates[t].get_mpz_t(), -1, witness_source) != verdicts[t])
+                ++mismatches;
+        }
+        auto end_native = std::chrono::high_resolution_clock::now();
+
+        double total_gmp = std::chrono::duration<double>(end_gmp - start_gmp).count();
+        double total_native = std::chrono::duration<double>(end_native - start_native).count();
+
+        std::cout << "Digits: " << digits << "\n";
+        std::cout << "  Avg [mpz Miller-Rabin]   : " << (total_gmp / num_trials) << " seconds\n";
+        std::cout << "  Avg [Fixed-width native] : " << (total_native / num_trials) << " seconds\n";
+        std::cout << "  Speedup                  : " << (total_gmp / total_native) << "x\n";
+        if (mismatches != 0)
+            std::cout << "  Mismatched verdicts      : " << mismatches << "\n";
+        std::cout << "\n";
+        gmp_path_times[digits] = total_gmp / num_trials;
+        native_times[digits] = total_native / num_trials;
+    }
+    // Print to file
+    std::ofstream file("Primality_Testing/data/fixed_width_benchmark.csv");
+    if (file.is_open()) {
+        file << "Digits,Mpz Time,Native Time\n";
+        for (const auto& size : digit_sizes) {
+            file << size << "," << gmp_path_times[size] << "," << native_times[size] << "\n";
+        }
+        file.close();
+    } else {
+        std::cerr << "Unable to open file for writing.\n";
+    }
+
+    gmp_randclear(rand_state);
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <gmp.h>
+#include <gmpxx.h>
+#include <fstream>
+#include <map>
+#include <vector>
+
+#include "primality/primality.h"
+
+int main() {
+    gmp_randstate_t rand_state;
+    gmp_randinit_mt(rand_state);
+    gmp_randseed_ui(rand_state, std::chrono::high_resolution_clock::now().time_since_epoch().count());
+
+    const std::vector<long long> digit_sizes = {100, 200, 300, 400, 500, 600, 700, 800, 900, 1000};
+    const int num_candidates = 20;
+    std::map<long long, double> powm_times;
+    std::map<long long, double> montgomery_times;
+    std::map<long long, double> lockstep_times;
+
+    // Rounds one base at a time, with each kernel, against all rounds in lockstep
+    MillerRabinContext powm_context;
+    MillerRabinContext montgomery_context;
+    montgomery_context.set_kernel(MillerRabinKernel::Montgomery);
+    MillerRabinContext lockstep_context;
+    for (auto* context : {&powm_context, &montgomery_context, &lockstep_context})
+        context->prefilter().set_limits(0, 0);
+
+    for (int digits : digit_sizes) {
+        double total_powm = 0.0;
+        double total_montgomery = 0.0;
+        double total_lockstep = 0.0;
+        int mismatches = 0;
+        int k = default_rounds(digits);
+
+        mpz_t n;
+        mpz_init(n);
+
+        for (int c = 0; c < num_candidates; ++c) {
+            // Primes, so every one of the k rounds is run
+            generate_random_mpz(n, rand_state, digits);
+            mpz_nextprime(n, n);
+
+            auto start_powm = std::chrono::high_resolution_clock::now();
+            bool result_powm = powm_context.is_prime_deterministic(n, k);
+            auto end_powm = std::chrono::high_resolution_clock::now();
+            total_powm += std::chrono::duration<double>(end_powm - start_powm).count();
+
+            auto start_montgomery = std::chrono::high_resolution_clock::now();
+            bool result_montgomery = montgomery_context.is_prime_deterministic(n, k);
+            auto end_montgomery = std::chrono::high_resolution_clock::now();
+            total_montgomery += std::chrono::duration<double>(end_montgomery - start_montgomery).count();
+
+            auto start_lockstep = std::chrono::high_resolution_clock::now();
+            bool result_lockstep = lockstep_context.is_prime_deterministic_lockstep(n, k);
+            auto end_lockstep = std::chrono::high_resolution_clock::now();
+            total_lockstep += std::chrono::duration<double>(end_lockstep - start_lockstep).count();
+
+            if (result_powm != result_montgomery || result_powm != result_lockstep)
+                ++mismatches;
+        }
+
+        mpz_clear(n);
+
+        std::cout << "Digits: " << digits << " (k = " << k << ")\n";
+        std::cout << "  Avg [Powm per base]      : " << (total_powm / num_candidates) << " seconds\n";
+        std::cout << "  Avg [Montgomery per base]: " << (total_montgomery / num_candidates) << " seconds\n";
+        std::cout << "  Avg [Lockstep]           : " << (total_lockstep / num_candidates) << " seconds\n";
+        std::cout << "  Speedup vs Powm          : " << (total_powm / total_lockstep) << "x\n";
+        std::cout << "  Speedup vs Montgomery    : " << (total_montgomery / total_lockstep) << "x\n";
+        if (mismatches != 0)
+            std::cout << "  Mismatched verdicts      : " << mismatches << "\n";
+        std::cout << "\n";
+        powm_times[digits] = total_powm / num_candidates;
+        montgomery_times[digits] = total_montgomery / num_candidates;
+        lockstep_times[digits] = total_lockstep / num_candidates;
+    }
+    // Print to file
+    std::ofstream file("Primality_Testing/data/lockstep_benchmark.csv");
+    if (file.is_open()) {
+        file << "Digits,Powm Time,Montgomery Time,Lockstep Time\n";
+        for (const auto& size : digit_sizes) {
+            file << size << "," << powm_times[size] << "," << montgomery_times[size] << ","
+                 << lockstep_times[size] << "\n";
+        }
+        file.close();
+    } else {
+        std::cerr << "Unable to open file for writing.\n";
+    }
+
+    gmp_randclear(rand_state);
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <gmp.h>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <vector>
+
+#include "primality/primality.h"
+
+// Previous witness routine: recomputes a^(2^r * d) from scratch on every step
+bool miller_test_reference(const mpz_t n, const mpz_t d, const mpz_t a) {
+    mpz_t x, n_minus_1, temp_d;
+    mpz_inits(x, n_minus_1, temp_d, NULL);
+    mpz_sub_ui(n_minus_1, n, 1);
+    mod_exp(x, a, d, n);
+
+    bool result = false;
+    if (mpz_cmp_ui(x, 1) == 0 || mpz_cmp(x, n_minus_1) == 0) {
+        result = true;
+    } else {
+        mpz_set(temp_d, d);
+        while (mpz_cmp(temp_d, n) < 0) {
+            mpz_mul_ui(temp_d, temp_d, 2);
+            mod_exp(x, a, temp_d, n);
+
+            if (mpz_cmp_ui(x, 1) == 0)
+                break;
+            if (mpz_cmp(x, n_minus_1) == 0) {
+                result = true;
+                break;
+            }
+        }
+    }
+
+    mpz_clears(x, n_minus_1, temp_d, NULL);
+    return result;
+}
+
+// Odd number with `num_digits` digits whose n - 1 is divisible by 2^s
+void generate_candidate(mpz_t result, gmp_randstate_t state, size_t num_digits, mp_bitcnt_t s) {
+    mpz_t lower;
+    mpz_init(lower);
+    mpz_ui_pow_ui(lower, 10, num_digits - 1);
+
+    mpz_urandomm(result, state, lower);
+    mpz_mul_ui(result, result, 9);
+    mpz_add(result, result, lower);             // result in [10^(d-1), 10^d)
+    mpz_fdiv_q_2exp(result, result, s);
+    mpz_mul_2exp(result, result, s);
+    mpz_add_ui(result, result, 1);              // result = m * 2^s + 1
+
+    mpz_clear(lower);
+}
+
+int main() {
+    gmp_randstate_t rand_state;
+    gmp_randinit_mt(rand_state);
+    gmp_randseed_ui(rand_state, std::chrono::high_resolution_clock::now().time_since_epoch().count());
+
+    const std::vector<long long> digit_sizes = {100, 200, 300, 400, 500, 600, 700, 800, 900, 1000};
+    const mp_bitcnt_t two_adic_order = 16;  // s = v2(n - 1) of every candidate
+    const int num_candidates = 20;
+    const int witnesses_per_candidate = 10;
+    std::map<long long, double> reference_times;
+    std::map<long long, double> chain_times;
+
+    for (int digits : digit_sizes) {
+        double total_reference = 0.0;
+        double total_chain = 0.0;
+        int mismatches = 0;
+
+        mpz_t n, n_minus_1, d, a, x;
+        mpz_inits(n, n_minus_1, d, a, x, NULL);
+
+        for (int c = 0; c < num_candidates; ++c) {
+            // Half the candidates are primes so the whole chain is walked
+            generate_candidate(n, rand_state, digits, two_adic_order);
+            if (c % 2 == 0) {
+                while (mpz_probab_prime_p(n, 5) == 0)
+                    mpz_add_ui(n, n, 1ul << two_adic_order);
+            }
+
+            mpz_sub_ui(n_minus_1, n, 1);
+            mp_bitcnt_t s = mpz_scan1(n_minus_1, 0);
+            mpz_tdiv_q_2exp(d, n_minus_1, s);
+
+            for (int w = 0; w < witnesses_per_candidate; ++w) {
+                mpz_sub_ui(a, n, 3);
+                mpz_urandomm(a, rand_state, a);
+                mpz_add_ui(a, a, 2);
+
+                auto start_reference = std::chrono::high_resolution_clock::now();
+                bool result_reference = miller_test_reference(n, d, a);
+                auto end_reference = std::chrono::high_resolution_clock::now();
+                total_reference += std::chrono::duration<double>(end_reference - start_reference).count();
+
+                auto start_chain = std::chrono::high_resolution_clock::now();
+                bool result_chain = miller_test(n, n_minus_1, d, s, a, x);
+                auto end_chain = std::chrono::high_resolution_clock::now();
+                total_chain += std::chrono::duration<double>(end_chain - start_chain).count();
+
+                if (result_reference != result_chain)
+                    ++mismatches;
+            }
+        }
+
+        mpz_clears(n, n_minus_1, d, a, x, NULL);
+
+        int num_witnesses = num_candidates * witnesses_per_candidate;
+        std::cout << "Digits: " << digits << "\n";
+        std::cout << "  Avg [Reference miller_test]: " << (total_reference / num_witnesses) << " seconds\n";
+        std::cout << "  Avg [Squaring chain]       : " << (total_chain / num_witnesses) << " seconds\n";
+        std::cout << "  Speedup                    : " << (total_reference / total_chain) << "x\n";
+        if (mismatches != 0)
+            std::cout << "  Mismatched verdicts        : " << mismatches << "\n";
+        std::cout << "\n";
+        reference_times[digits] = total_reference / num_witnesses;
+        chain_times[digits] = total_chain / num_witnesses;
+    }
+    // Print to file
+    std::ofstream file("Primality_Testing/data/miller_test_benchmark.csv");
+    if (file.is_open()) {
+        file << "Digits,Reference Time,Chain Time\n";
+        for (const auto& size : digit_sizes) {
+            file << size << "," << reference_times[size] << "," << chain_times[size] << "\n";
+        }
+        file.close();
+    } else {
+        std::cerr << "Unable to open file for writing.\n";
+    }
+
+    gmp_randclear(rand_state);
+    return 0;
+}
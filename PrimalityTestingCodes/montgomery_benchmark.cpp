@@ -0,0 +1,93 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <gmp.h>
+#include <gmpxx.h>
+#include <fstream>
+#include <map>
+#include <vector>
+
+#include "primality/primality.h"
+
+int main() {
+    gmp_randstate_t rand_state;
+    gmp_randinit_mt(rand_state);
+    gmp_randseed_ui(rand_state, std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    MersenneTwisterSource witness_source(1);
+
+    const std::vector<long long> digit_sizes = {100, 200, 300, 400, 500, 600, 700, 800, 900, 1000};
+    const int num_candidates = 20;
+    std::map<long long, double> powm_times;
+    std::map<long long, double> montgomery_times;
+
+    MillerRabinContext context;
+    context.set_kernel(MillerRabinKernel::Montgomery);
+
+    for (int digits : digit_sizes) {
+        double total_powm = 0.0;
+        double total_montgomery = 0.0;
+        int mismatches = 0;
+        int k = default_rounds(digits);
+
+        mpz_t n, n_minus_1, d, x;
+        mpz_inits(n, n_minus_1, d, x, NULL);
+        std::vector<mpz_class> witnesses(k);
+
+        for (int c = 0; c < num_candidates; ++c) {
+            // Primes, so every one of the k rounds is run
+            generate_random_mpz(n, rand_state, digits);
+            mpz_nextprime(n, n);
+            for (auto& a : witnesses)
+                witness_source.next(a.get_mpz_t(), n);
+
+            // mpz_powm per witness, with its reduction set up on every call
+            auto start_powm = std::chrono::high_resolution_clock::now();
+            mpz_sub_ui(n_minus_1, n, 1);
+            mp_bitcnt_t s = mpz_scan1(n_minus_1, 0);
+            mpz_tdiv_q_2exp(d, n_minus_1, s);
+            bool result_powm = true;
+            for (const auto& a : witnesses)
+                result_powm = miller_test(n, n_minus_1, d, s, a.get_mpz_t(), x) && result_powm;
+            auto end_powm = std::chrono::high_resolution_clock::now();
+            total_powm += std::chrono::duration<double>(end_powm - start_powm).count();
+
+            // One Montgomery context for the candidate, shared by all witnesses
+            auto start_montgomery = std::chrono::high_resolution_clock::now();
+            context.prepare(n);
+            bool result_montgomery = true;
+            for (const auto& a : witnesses)
+                result_montgomery = context.test(a.get_mpz_t()) && result_montgomery;
+            auto end_montgomery = std::chrono::high_resolution_clock::now();
+            total_montgomery += std::chrono::duration<double>(end_montgomery - start_montgomery).count();
+
+            if (result_powm != result_montgomery)
+                ++mismatches;
+        }
+
+        mpz_clears(n, n_minus_1, d, x, NULL);
+
+        std::cout << "Digits: " << digits << " (k = " << k << ")\n";
+        std::cout << "  Avg [mpz_powm per witness]: " << (total_powm / num_candidates) << " seconds\n";
+        std::cout << "  Avg [Shared Montgomery]   : " << (total_montgomery / num_candidates) << " seconds\n";
+        std::cout << "  Speedup                   : " << (total_powm / total_montgomery) << "x\n";
+        if (mismatches != 0)
+            std::cout << "  Mismatched verdicts       : " << mismatches << "\n";
+        std::cout << "\n";
+        powm_times[digits] = total_powm / num_candidates;
+        montgomery_times[digits] = total_montgomery / num_candidates;
+    }
+    // Print to file
+    std::ofstream file("Primality_Testing/data/montgomery_benchmark.csv");
+    if (file.is_open()) {
+        file << "Digits,Powm Time,Montgomery Time\n";
+        for (const auto& size : digit_sizes) {
+            file << size << "," << powm_times[size] << "," << montgomery_times[size] << "\n";
+        }
+        file.close();
+    } else {
+        std::cerr << "Unable to open file for writing.\n";
+    }
+
+    gmp_randclear(rand_state);
+    return 0;
+}
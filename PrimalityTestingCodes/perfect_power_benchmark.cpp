@@ -0,0 +1,109 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <gmp.h>
+#include <gmpxx.h>
+#include <fstream>
+#include <functional>
+#include <vector>
+
+#include "primality/primality.h"
+
+// The original AKS step 1: every exponent b, with two mpz_pow_ui checks each
+bool every_exponent_perfect_power(const mpz_class& n) {
+    if (n < 2) return false;
+
+    unsigned long max_b = mpz_sizeinbase(n.get_mpz_t(), 2);
+    for (unsigned long b = 2; b <= max_b; ++b) {
+        mpz_class root;
+        mpz_root(root.get_mpz_t(), n.get_mpz_t(), b);
+
+        mpz_class power;
+        mpz_pow_ui(power.get_mpz_t(), root.get_mpz_t(), b);
+        if (power == n) {
+            return true;
+        }
+
+        mpz_class root_plus_1 = root + 1;
+        mpz_pow_ui(power.get_mpz_t(), root_plus_1.get_mpz_t(), b);
+        if (power == n) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main() {
+    gmp_randstate_t rand_state;
+    gmp_randinit_mt(rand_state);
+    gmp_randseed_ui(rand_state, std::chrono::high_resolution_clock::now().time_since_epoch().count());
+
+    const std::vector<unsigned long> bit_sizes = {64, 128, 256, 512, 1024, 2048};
+    const int num_inputs = 200;
+    // The old detector is quadratic in the exponent range, so it is skipped above this size
+    const unsigned long baseline_bits = 1024;
+
+    struct Detector {
+        std::string name;
+        std::function<bool(const mpz_class&)> detect;
+    };
+    const std::vector<Detector> detectors = {
+        {"Every exponent", every_exponent_perfect_power},
+        {"Prime exponents", [](const mpz_class& n) { return is_perfect_power(n); }},
+        {"mpz_perfect_power_p", [](const mpz_class& n) { return mpz_perfect_power_p(n.get_mpz_t()) != 0; }},
+    };
+
+    // Builds the residue screen table outside the timings
+    is_perfect_power(mpz_class(3));
+
+    std::ofstream file("Primality_Testing/data/perfect_power_benchmark.csv");
+    if (file.is_open())
+        file << "Bits,Inputs,Detector,Time,Powers Found\n";
+    else
+        std::cerr << "Unable to open file for writing.\n";
+
+    for (unsigned long bits : bit_sizes) {
+        // Odd non-powers, which pay for the whole exponent range, and exact
+        // powers m^p of about the same size with a random prime p
+        std::vector<mpz_class> random_inputs(num_inputs), power_inputs(num_inputs);
+        for (auto& n : random_inputs) {
+            mpz_urandomb(n.get_mpz_t(), rand_state, bits);
+            mpz_setbit(n.get_mpz_t(), bits - 1);
+            mpz_setbit(n.get_mpz_t(), 0);
+        }
+        for (auto& n : power_inputs) {
+            mpz_class p;
+            do {
+                p = 3 + gmp_urandomm_ui(rand_state, bits / 8);
+            } while (!mpz_probab_prime_p(p.get_mpz_t(), 25));
+            unsigned long exponent = p.get_ui();
+            mpz_class m;
+            mpz_urandomb(m.get_mpz_t(), rand_state, bits / exponent);
+            m += 2;
+            mpz_pow_ui(n.get_mpz_t(), m.get_mpz_t(), exponent);
+        }
+
+        std::cout << "Bits: " << bits << "\n";
+        for (const auto& inputs : {std::make_pair("random", &random_inputs), std::make_pair("powers", &power_inputs)}) {
+            for (const auto& detector : detectors) {
+                if (bits > baseline_bits && detector.name == "Every exponent")
+                    continue;
+                int found = 0;
+                auto start = std::chrono::high_resolution_clock::now();
+                for (const auto& n : *inputs.second)
+                    found += detector.detect(n);
+                auto end = std::chrono::high_resolution_clock::now();
+                double avg = std::chrono::duration<double>(end - start).count() / num_inputs;
+
+                std::cout << "  [" << inputs.first << "] " << detector.name << ": " << avg << " seconds per input ("
+                          << found << " powers)\n";
+                if (file.is_open())
+                    file << bits << "," << inputs.first << "," << detector.name << "," << avg << "," << found << "\n";
+            }
+        }
+        std::cout << "\n";
+    }
+
+    gmp_randclear(rand_state);
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <gmp.h>
+#include <gmpxx.h>
+#include <fstream>
+#include <vector>
+
+#include "primality/primality.h"
+
+int main() {
+    gmp_randstate_t rand_state;
+    gmp_randinit_mt(rand_state);
+    gmp_randseed_ui(rand_state, std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    MersenneTwisterSource witness_source(1);
+
+    const std::vector<long long> digit_sizes = {50, 100, 200, 300, 500, 1000};
+    // Trial division cutoffs to compare; 0 runs Miller-Rabin on every odd candidate
+    const std::vector<uint32_t> trial_limits = {0, 256, 1024, 4096, 16383};
+    const int num_candidates = 2000;
+
+    MillerRabinContext context;
+    set_prefilter_counting(true);
+
+    std::ofstream file("Primality_Testing/data/prefilter_benchmark.csv");
+    if (file.is_open())
+        file << "Digits,Trial Limit,Time,Gcd Rejected,Trial Rejected,Miller-Rabin Rejected,Probable Primes\n";
+    else
+        std::cerr << "Unable to open file for writing.\n";
+
+    for (int digits : digit_sizes) {
+        // Random odd candidates, as a prime search would see them
+        std::vector<mpz_class> candidates(num_candidates);
+        for (auto& n : candidates) {
+            generate_random_mpz(n.get_mpz_t(), rand_state, digits);
+            mpz_setbit(n.get_mpz_t(), 0);
+        }
+        int k = default_rounds(digits);
+
+        std::cout << "Digits: " << digits << " (k = " << k << ")\n";
+        for (uint32_t trial_limit : trial_limits) {
+            uint32_t gcd_limit = trial_limit == 0 ? 0 : std::min(trial_limit, Prefilter::default_gcd_limit);
+            context.prefilter().set_limits(gcd_limit, trial_limit);
+            reset_prefilter_stats();
+
+            auto start = std::chrono::high_resolution_clock::now();
+            for (const auto& n : candidates)
+                context.is_probable_prime(n.get_mpz_t(), k, witness_source);
+            auto end = std::chrono::high_resolution_clock::now();
+            double avg = std::chrono::duration<double>(end - start).count() / num_candidates;
+
+            PrefilterStats stats = prefilter_stats();
+            std::cout << "  Trial limit " << trial_limit << ": " << avg << " seconds per candidate"
+                      << "  [gcd " << stats.gcd << ", trial " << stats.trial_division
+                      << ", MR " << stats.miller_rabin << ", prime " << stats.probable_prime << "]\n";
+            if (file.is_open())
+                file << digits << "," << trial_limit << "," << avg << "," << stats.gcd << "," << stats.trial_division
+                     << "," << stats.miller_rabin << "," << stats.probable_prime << "\n";
+        }
+        std::cout << "\n";
+    }
+
+    gmp_randclear(rand_state);
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include "primality/aks.h"
+
+#include <memory>
+
+bool aks_congruence_holds(PolyModN& poly, const mpz_class& n, unsigned long a, const std::atomic<bool>* cancel) {
+    if (!poly.pow_x_plus_a(a, n.get_mpz_t(), cancel))
+        return false;
+    return poly.equals_x_power_plus(mpz_fdiv_ui(n.get_mpz_t(), poly.size()), a);
+}
+
+bool aks_congruence_holds(const mpz_class& n, unsigned long a, unsigned long r) {
+    PolyModN poly(n, r);
+    return aks_congruence_holds(poly, n, a);
+}
+
+bool aks_is_prime(const mpz_class& n, ThreadPool* pool) {
+    if (n < 2) {
+        return false;
+    }
+
+    // Step 1: Check if n is a perfect power
+    if (is_perfect_power(n)) {
+        return false;
+    }
+
+    // Steps 2-3: the smallest r with order_r(n) > log2(n)^2, then
+    // gcd(a, n) for 2 <= a < min(r, n)
+    AksParameters params = select_aks_parameters(n);
+    if (params.has_small_factor) {
+        return false;
+    }
+    unsigned long r = params.r;
+
+    // Step 4: If n ≤ r, then n is prime
+    if (n <= r) {
+        return true;
+    }
+
+    // Step 5: Polynomial congruence check
+    unsigned long limit = params.limit;
+    ThreadPool& workers = pool ? *pool : default_thread_pool();
+    if (workers.size() < 2) {
+        // One polynomial serves every a, so step 5 allocates only here
+        PolyModN poly(n, r);
+        for (unsigned long a = 1; a <= limit; ++a) {
+            if (!aks_congruence_holds(poly, n, a)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Equal costs deal a = 1, 2, ... round robin, so each worker walks up
+    // from small a and one polynomial per worker serves all of its a
+    std::vector<std::unique_ptr<PolyModN>> scratch(workers.size());
+    std::vector<double> costs(limit, 1.0);
+    std::atomic<bool> composite{false};
+    workers.run(costs, [&](size_t i, unsigned worker) {
+        if (composite.load(std::memory_order_relaxed))
+            return;
+        if (!scratch[worker])
+            scratch[worker] = std::make_unique<PolyModN>(n, r);
+        if (!aks_congruence_holds(*scratch[worker], n, i + 1, &composite) &&
+            !composite.load(std::memory_order_relaxed))
+            composite.store(true, std::memory_order_relaxed);
+    });
+    if (composite.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    // Step 6: Passed all tests
+    return true;
+}
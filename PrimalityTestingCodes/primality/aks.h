@@ -0,0 +1,24 @@
+#ifndef PRIMALITY_AKS_H
+#define PRIMALITY_AKS_H
+
+#include <gmp.h>
+#include <gmpxx.h>
+
+#include "primality/aks_params.h"
+#include "primality/perfect_power.h"
+#include "primality/polynomial.h"
+#include "primality/thread_pool.h"
+
+// Whether (x + a)^n = x^n + a in Z_n[x]/(x^r - 1), with a < n. `poly` is
+// the scratch polynomial for this n and r and is overwritten. If *cancel is
+// set part way the check stops early and its result is meaningless.
+bool aks_congruence_holds(PolyModN& poly, const mpz_class& n, unsigned long a,
+                          const std::atomic<bool>* cancel = nullptr);
+bool aks_congruence_holds(const mpz_class& n, unsigned long a, unsigned long r);
+
+// Agrawal-Kayal-Saxena deterministic primality test. The step 5 congruences
+// run on `pool` (the default pool if null), each worker with its own
+// polynomial scratch, and all stop once one a fails.
+bool aks_is_prime(const mpz_class& n, ThreadPool* pool = nullptr);
+
+#endif
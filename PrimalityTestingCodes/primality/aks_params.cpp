@@ -0,0 +1,165 @@
+#include "primality/aks_params.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "primality/fixed_width.h"
+
+namespace {
+
+// Smallest prime factor of every integer below a bound that grows on demand
+class FactorSieve {
+public:
+    explicit FactorSieve(uint64_t limit) { grow(limit); }
+
+    // Makes every x <= limit factorable, at least doubling the bound so the
+    // resieving stays linear overall
+    void ensure(uint64_t limit) {
+        if (limit >= spf_.size())
+            grow(std::max<uint64_t>(limit, 2 * spf_.size()));
+    }
+
+    bool is_prime(uint64_t x) const { return x >= 2 && spf_[x] == x; }
+
+    // Distinct prime factors of x in increasing order
+    void factor(uint64_t x, std::vector<uint64_t>& primes) const {
+        primes.clear();
+        while (x > 1) {
+            uint64_t p = spf_[x];
+            primes.push_back(p);
+            while (x % p == 0)
+                x /= p;
+        }
+    }
+
+    uint64_t phi(uint64_t x) const {
+        uint64_t result = x;
+        while (x > 1) {
+            uint64_t p = spf_[x];
+            result -= result / p;
+            while (x % p == 0)
+                x /= p;
+        }
+        return result;
+    }
+
+private:
+    void grow(uint64_t limit) {
+        spf_.assign(limit + 1, 0);
+        for (uint64_t i = 2; i <= limit; ++i) {
+            if (spf_[i] != 0)
+                continue;
+            spf_[i] = static_cast<uint32_t>(i);
+            for (uint64_t m = i * i; m <= limit; m += i)
+                if (spf_[m] == 0)
+                    spf_[m] = static_cast<uint32_t>(i);
+        }
+    }
+
+    std::vector<uint32_t> spf_;
+};
+
+uint64_t mul_mod(uint64_t a, uint64_t b, uint64_t m) {
+    return static_cast<uint64_t>(static_cast<uint128_t>(a) * b % m);
+}
+
+uint64_t pow_mod(uint64_t base, uint64_t exp, uint64_t m) {
+    uint64_t result = 1 % m;
+    while (exp > 0) {
+        if (exp & 1)
+            result = mul_mod(result, base, m);
+        base = mul_mod(base, base, m);
+        exp >>= 1;
+    }
+    return result;
+}
+
+// Whether n^k mod r avoids 0 and 1 for every 1 <= k <= max_k, given n mod r
+bool order_exceeds(uint64_t n_mod_r, uint64_t r, uint64_t max_k, const FactorSieve& sieve,
+                   std::vector<uint64_t>& primes) {
+    if (std::gcd(n_mod_r, r) != 1) {
+        // Powers never reach 1 but may reach 0; walk them once, incrementally
+        uint64_t power = 1;
+        for (uint64_t k = 1; k <= max_k; ++k) {
+            power = mul_mod(power, n_mod_r, r);
+            if (power <= 1)
+                return false;
+        }
+        return true;
+    }
+
+    // The order divides phi(r), so most small r are out without a single power
+    uint64_t order = sieve.phi(r);
+    if (order <= max_k)
+        return false;
+    sieve.factor(order, primes);
+    for (uint64_t q : primes) {
+        while (order % q == 0 && pow_mod(n_mod_r, order / q, r) == 1)
+            order /= q;
+        if (order <= max_k)
+            return false;
+    }
+    return true;
+}
+
+uint64_t max_order_bound(const mpz_class& n) {
+    uint64_t logn = mpz_sizeinbase(n.get_mpz_t(), 2);
+    return logn * logn;
+}
+
+unsigned long smallest_r(const mpz_class& n, FactorSieve& sieve) {
+    uint64_t max_k = max_order_bound(n);
+    std::vector<uint64_t> primes;
+    for (uint64_t r = 2;; ++r) {
+        sieve.ensure(r);
+        if (order_exceeds(mpz_fdiv_ui(n.get_mpz_t(), r), r, max_k, sieve, primes))
+            return r;
+    }
+}
+
+}  // namespace
+
+AksParameters select_aks_parameters(const mpz_class& n) {
+    FactorSieve sieve(1024);
+
+    AksParameters params;
+    params.r = smallest_r(n, sieve);
+    params.phi = sieve.phi(params.r);
+    double logn = mpz_sizeinbase(n.get_mpz_t(), 2);
+    params.limit = static_cast<unsigned long>(std::floor(std::sqrt(static_cast<double>(params.phi)) * logn));
+
+    // Some a below the bound shares a factor with n iff some prime below it divides n
+    unsigned long bound = params.r;
+    if (mpz_cmp_ui(n.get_mpz_t(), bound) < 0)
+        bound = mpz_get_ui(n.get_mpz_t());
+    for (unsigned long p = 2; p < bound; ++p) {
+        if (sieve.is_prime(p) && mpz_divisible_ui_p(n.get_mpz_t(), p)) {
+            params.has_small_factor = true;
+            break;
+        }
+    }
+    return params;
+}
+
+unsigned long find_r(const mpz_class& n) {
+    FactorSieve sieve(1024);
+    return smallest_r(n, sieve);
+}
+
+unsigned long euler_phi(unsigned long r) {
+    // A single r is cheaper to factor by trial division than to sieve for
+    unsigned long result = r;
+    for (unsigned long p = 2; p * p <= r; ++p) {
+        if (r % p != 0)
+            continue;
+        result -= result / p;
+        while (r % p == 0)
+            r /= p;
+    }
+    if (r > 1)
+        result -= result / r;
+    return result;
+}
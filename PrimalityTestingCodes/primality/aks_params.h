@@ -0,0 +1,27 @@
+#ifndef PRIMALITY_AKS_PARAMS_H
+#define PRIMALITY_AKS_PARAMS_H
+
+#include <gmp.h>
+#include <gmpxx.h>
+
+// Everything AKS needs before the polynomial checks, for one n >= 2
+struct AksParameters {
+    unsigned long r = 0;            // smallest r with ord_r(n) > log2(n)^2
+    unsigned long phi = 0;          // euler_phi(r)
+    unsigned long limit = 0;        // floor(sqrt(phi) * log2(n)), the largest a of step 5
+    bool has_small_factor = false;  // gcd(a, n) > 1 for some 2 <= a < min(r, n)
+};
+
+// Steps 2-3 and phi(r) in one pass. n is reduced mod each candidate r once
+// and everything after that is word arithmetic over a smallest-factor sieve
+// of the r range: phi(r) comes from the factorization of r, the order of n
+// from the factorization of phi(r), and step 3 only tries the primes.
+AksParameters select_aks_parameters(const mpz_class& n);
+
+// Smallest r with order_r(n) > log2(n)^2
+unsigned long find_r(const mpz_class& n);
+
+// Number of integers in [1, r] coprime to r
+unsigned long euler_phi(unsigned long r);
+
+#endif
@@ -0,0 +1,43 @@
+#include "primality/miller_rabin_context.h"
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+namespace {
+
+std::atomic<unsigned long> allocations{0};
+std::mutex install_mutex;
+int counting_users = 0;
+
+void* (*base_alloc)(size_t);
+void* (*base_realloc)(void*, size_t, size_t);
+void (*base_free)(void*, size_t);
+
+void* counting_alloc(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return base_alloc(size);
+}
+
+void* counting_realloc(void* ptr, size_t old_size, size_t new_size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return base_realloc(ptr, old_size, new_size);
+}
+
+}  // namespace
+
+void set_gmp_allocation_counting(bool enabled) {
+    std::lock_guard<std::mutex> lock(install_mutex);
+    if (enabled) {
+        if (counting_users++ == 0) {
+            mp_get_memory_functions(&base_alloc, &base_realloc, &base_free);
+            mp_set_memory_functions(counting_alloc, counting_realloc, base_free);
+        }
+    } else if (counting_users > 0 && --counting_users == 0) {
+        mp_set_memory_functions(base_alloc, base_realloc, base_free);
+    }
+}
+
+unsigned long gmp_allocation_count() {
+    return allocations.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,84 @@
+#include "primality/batch_prefilter.h"
+
+#include <algorithm>
+#include <cstddef>
+
+BatchPrefilter::BatchPrefilter(uint32_t prime_limit) : prime_limit_(std::max<uint32_t>(prime_limit, 2)) {
+    mpz_primorial_ui(primorial_.get_mpz_t(), prime_limit_);
+    mpz_tdiv_q_2exp(primorial_.get_mpz_t(), primorial_.get_mpz_t(), 1);  // drop the prime 2
+    proven_bound_ = prime_limit_;
+    proven_bound_ *= prime_limit_;
+}
+
+void BatchPrefilter::screen(std::span<const mpz_class> numbers, std::span<int> verdicts) {
+    size_t count = std::min(numbers.size(), verdicts.size());
+
+    // Even numbers and those below 3 are decided without the tree
+    if (tree_.empty())
+        tree_.resize(1);
+    std::vector<mpz_class>& leaves = tree_[0];
+    leaves.clear();
+    leaf_of_.assign(count, SIZE_MAX);
+    for (size_t i = 0; i < count; ++i) {
+        const mpz_class& n = numbers[i];
+        if (n < 3 || mpz_even_p(n.get_mpz_t())) {
+            verdicts[i] = n == 2 ? 1 : 0;
+            continue;
+        }
+        leaf_of_[i] = leaves.size();
+        leaves.push_back(n);
+    }
+    if (leaves.empty())
+        return;
+
+    // Product tree: each level pairs up the one below, an odd node moves up
+    // as is. Once every node exceeds the primorial, the primorial is its own
+    // remainder modulo each of them, so the levels above are never built.
+    size_t primorial_bits = mpz_sizeinbase(primorial_.get_mpz_t(), 2);
+    size_t levels = 1;
+    for (;;) {
+        const std::vector<mpz_class>& below = tree_[levels - 1];
+        size_t smallest = SIZE_MAX;
+        for (const auto& node : below)
+            smallest = std::min(smallest, mpz_sizeinbase(node.get_mpz_t(), 2));
+        if (below.size() == 1 || smallest > primorial_bits)
+            break;
+        if (tree_.size() <= levels)
+            tree_.emplace_back();
+        // emplace_back may have moved the levels
+        const std::vector<mpz_class>& lower = tree_[levels - 1];
+        std::vector<mpz_class>& level = tree_[levels];
+        level.resize((lower.size() + 1) / 2);
+        for (size_t j = 0; j + 1 < lower.size(); j += 2)
+            mpz_mul(level[j / 2].get_mpz_t(), lower[j].get_mpz_t(), lower[j + 1].get_mpz_t());
+        if (lower.size() % 2)
+            level.back() = lower.back();
+        ++levels;
+    }
+
+    // Remainder tree: every node is replaced by the primorial mod that node,
+    // from the remainder at its parent
+    for (auto& node : tree_[levels - 1])
+        mpz_mod(node.get_mpz_t(), primorial_.get_mpz_t(), node.get_mpz_t());
+    for (size_t h = levels - 1; h-- > 0;) {
+        const std::vector<mpz_class>& above = tree_[h + 1];
+        std::vector<mpz_class>& level = tree_[h];
+        for (size_t j = 0; j < level.size(); ++j)
+            mpz_mod(level[j].get_mpz_t(), above[j / 2].get_mpz_t(), level[j].get_mpz_t());
+    }
+
+    const std::vector<mpz_class>& remainders = tree_[0];
+    for (size_t i = 0; i < count; ++i) {
+        if (leaf_of_[i] == SIZE_MAX)
+            continue;
+        const mpz_class& n = numbers[i];
+        mpz_gcd(gcd_.get_mpz_t(), remainders[leaf_of_[i]].get_mpz_t(), n.get_mpz_t());
+        if (gcd_ == 1)
+            verdicts[i] = n < proven_bound_ ? 1 : -1;
+        else if (gcd_ == n)
+            // n divides the primorial, so it is a product of distinct small primes
+            verdicts[i] = mpz_probab_prime_p(n.get_mpz_t(), 1) ? 1 : 0;
+        else
+            verdicts[i] = 0;
+    }
+}
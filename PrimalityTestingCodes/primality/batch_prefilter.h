@@ -0,0 +1,40 @@
+#ifndef PRIMALITY_BATCH_PREFILTER_H
+#define PRIMALITY_BATCH_PREFILTER_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <gmp.h>
+#include <gmpxx.h>
+
+// Small-factor screening of a whole batch at once, in the style of
+// Bernstein's batch gcd: the candidates are multiplied up a product tree,
+// the primorial of the odd primes up to prime_limit is reduced down the
+// matching remainder tree, and each leaf ends with gcd(primorial mod n, n).
+// The cost is a few multiplications of the size of the whole batch rather
+// than one division per candidate and prime, so far larger limits pay off
+// than Prefilter's trial division.
+class BatchPrefilter {
+public:
+    static constexpr uint32_t default_prime_limit = 1u << 20;
+
+    explicit BatchPrefilter(uint32_t prime_limit = default_prime_limit);
+
+    uint32_t prime_limit() const { return prime_limit_; }
+
+    // verdicts[i] for numbers[i] as Prefilter::screen gives it: 0 if the
+    // number is below 2 or has a prime factor up to the limit, 1 if that
+    // proves it prime, -1 if Miller-Rabin is needed. Only the first
+    // min(sizes) entries are touched. Does not record prefilter stages.
+    void screen(std::span<const mpz_class> numbers, std::span<int> verdicts);
+
+private:
+    uint32_t prime_limit_;
+    mpz_class primorial_;                       // product of the odd primes up to prime_limit
+    mpz_class proven_bound_;                    // prime_limit^2
+    std::vector<std::vector<mpz_class>> tree_;  // tree_[0] holds the leaves; reused between batches
+    std::vector<size_t> leaf_of_;               // leaf of each number, or SIZE_MAX if decided directly
+    mpz_class gcd_;
+};
+
+#endif
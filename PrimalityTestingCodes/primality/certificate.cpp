@@ -0,0 +1,345 @@
+#include "primality/certificate.h"
+
+#include <map>
+#include <set>
+#include <sstream>
+
+#include "primality/elliptic_curve.h"
+#include "primality/fixed_width.h"
+#include "primality/primality.h"
+
+namespace {
+
+constexpr const char* certificate_header = "primality-certificate 1";
+
+// Bases tried per q before giving up; for a prime n a base fails with
+// probability 1/q, so this is only reached for a composite n
+constexpr unsigned long max_witness_base = 1000;
+
+// Rho steps per composite in the quick first pass over n - 1
+constexpr uint64_t quick_rho_iterations = uint64_t(1) << 14;
+
+// True if s^2 - 4t is a square for s >= 2, t >= 1, i.e. if x^2 - s x + t has
+// positive integer roots k and l
+bool splits(const mpz_class& s, const mpz_class& t) {
+    if (s < 2 || t < 1)
+        return false;
+    mpz_class d = s * s - 4 * t;
+    return d >= 0 && mpz_perfect_square_p(d.get_mpz_t());
+}
+
+// Given that every prime factor of n is 1 mod F, true if that proves n prime.
+// With F^3 >= n a composite n has exactly two such factors (1 + kF)(1 + lF),
+// and kl < F gives n - 1 = F((k + l) + klF) with k + l <= F, so writing
+// (n - 1) / F = c2 F + c1 the pair (k + l, kl) is (c1, c2), or (F, c2 - 1)
+// when k + l = F.
+bool factored_part_suffices(const mpz_class& n, const mpz_class& F) {
+    if ((F + 1) * (F + 1) > n)
+        return true;
+    if (F * F * F < n)
+        return false;
+    mpz_class r = (n - 1) / F;
+    mpz_class c2, c1;
+    mpz_fdiv_qr(c2.get_mpz_t(), c1.get_mpz_t(), r.get_mpz_t(), F.get_mpz_t());
+    return !splits(c1, c2) && !(c1 == 0 && splits(F, c2 - 1));
+}
+
+enum class Witness { Good, Useless, Composite };
+
+// Pocklington's condition for one q | n - 1 and base a
+Witness check_witness(const mpz_class& n, const mpz_class& q, unsigned long a) {
+    mpz_class n_minus_1 = n - 1;
+    mpz_class e = n_minus_1 / q;
+    mpz_class t, u;
+    mpz_class base = a;
+    mpz_powm(t.get_mpz_t(), base.get_mpz_t(), e.get_mpz_t(), n.get_mpz_t());
+    mpz_powm(u.get_mpz_t(), t.get_mpz_t(), q.get_mpz_t(), n.get_mpz_t());
+    if (u != 1)
+        return Witness::Composite;
+    u = t - 1;
+    mpz_gcd(u.get_mpz_t(), u.get_mpz_t(), n.get_mpz_t());
+    if (u == 1)
+        return Witness::Good;
+    return u == n ? Witness::Useless : Witness::Composite;
+}
+
+bool verify_small(const CertificateEntry& entry) {
+    return entry.witnesses.empty() && entry.n >= 0 && mpz_sizeinbase(entry.n.get_mpz_t(), 2) <= 64 &&
+           is_prime_u64(mpz_get_ui(entry.n.get_mpz_t()));
+}
+
+bool verify_n_minus_1(const CertificateEntry& entry, const std::set<mpz_class>& proven) {
+    const mpz_class& n = entry.n;
+    if (n < 3 || entry.witnesses.empty())
+        return false;
+
+    // F = (n - 1) / r, where r is n - 1 with every listed q divided out
+    mpz_class n_minus_1 = n - 1;
+    mpz_class r = n_minus_1;
+    for (const auto& [q, a] : entry.witnesses) {
+        if (!proven.count(q) || a < 2 || !mpz_divisible_p(r.get_mpz_t(), q.get_mpz_t()))
+            return false;  // also rejects a q listed twice
+        mpz_remove(r.get_mpz_t(), r.get_mpz_t(), q.get_mpz_t());
+    }
+    mpz_class F = n_minus_1 / r;
+    if (!factored_part_suffices(n, F))
+        return false;
+
+    for (const auto& [q, a] : entry.witnesses) {
+        if (check_witness(n, q, a) != Witness::Good)
+            return false;
+    }
+    return true;
+}
+
+bool verify_elliptic(const CertificateEntry& entry, const std::set<mpz_class>& proven) {
+    const mpz_class& n = entry.n;
+    const EllipticProof& proof = entry.elliptic;
+    if (n < 5 || mpz_divisible_ui_p(n.get_mpz_t(), 2) || mpz_divisible_ui_p(n.get_mpz_t(), 3) ||
+        !entry.witnesses.empty())
+        return false;
+    if (!proven.count(proof.q) || proof.m < 1 || !mpz_divisible_p(proof.m.get_mpz_t(), proof.q.get_mpz_t()) ||
+        !exceeds_hasse_bound(proof.q, n))
+        return false;
+    if (proof.x < 0 || proof.x >= n || proof.y < 0 || proof.y >= n)
+        return false;
+
+    EllipticCurveModN curve(n, proof.a, proof.b);
+    CurvePoint p{proof.x, proof.y};
+    if (!curve.nonsingular() || !curve.contains(p))
+        return false;
+    CurvePoint r;
+    if (!curve.multiply(r, p, proof.m / proof.q) || r.infinity)
+        return false;
+    return curve.multiply(r, r, proof.q) && r.infinity;
+}
+
+class Certifier {
+public:
+    Certifier(const FactorizationOptions& options, PrimalityCertificate& certificate)
+        : options_(options), certificate_(certificate) {
+        if (options.time_budget > 0)
+            deadline_ = std::chrono::steady_clock::now() +
+                        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                            std::chrono::duration<double>(options.time_budget));
+    }
+
+    // Appends entries proving n after those for the primes it relies on
+    bool prove(const mpz_class& n) {
+        auto known = outcome_.find(n);
+        if (known != outcome_.end())
+            return known->second;
+        // A failed proof drops the entries it added, which nothing else uses
+        size_t kept = certificate_.entries.size();
+        bool proven = prove_new(n);
+        if (!proven) {
+            for (size_t i = kept; i < certificate_.entries.size(); ++i)
+                outcome_.erase(certificate_.entries[i].n);
+            certificate_.entries.resize(kept);
+        }
+        outcome_.emplace(n, proven);
+        return proven;
+    }
+
+private:
+    // Seconds left, or 0 for no limit (as FactorizationOptions reads it);
+    // negative once the deadline has passed
+    double remaining() const {
+        if (deadline_ == no_factor_deadline)
+            return 0;
+        double left = std::chrono::duration<double>(deadline_ - std::chrono::steady_clock::now()).count();
+        return left > 0 ? left : -1;
+    }
+
+    bool prove_new(const mpz_class& n) {
+        if (n < 2)
+            return false;
+        if (mpz_sizeinbase(n.get_mpz_t(), 2) <= 64) {
+            if (!is_prime_u64(mpz_get_ui(n.get_mpz_t())))
+                return false;
+            certificate_.entries.push_back({CertificateKind::Small, n, {}, {}});
+            return true;
+        }
+        if (!is_bpsw_prime(n.get_mpz_t()))
+            return false;
+
+        // Trial division and a short rho run first; the full stages only if
+        // that leaves n - 1 too little factored
+        FactorizationOptions quick = options_;
+        quick.rho_iterations = quick_rho_iterations;
+        quick.pm1_bound = 0;
+        quick.ecm_curves = 0;
+        mpz_class n_minus_1 = n - 1;
+        Factorization factors;
+        if (!factor_within_budget(n_minus_1, quick, factors))
+            return false;
+        if (!enough(n, n_minus_1, factors) && !factors.complete()) {
+            if (!factor_within_budget(n_minus_1, options_, factors))
+                return false;
+        }
+
+        // Prove the smallest q first, as they are cheapest, until F suffices
+        CertificateEntry entry{CertificateKind::NMinus1, n, {}, {}};
+        mpz_class F = 1;
+        for (const auto& [q, exponent] : factors.primes) {
+            if (factored_part_suffices(n, F))
+                break;
+            if (!prove(q))
+                continue;
+            mpz_class power;
+            mpz_pow_ui(power.get_mpz_t(), q.get_mpz_t(), exponent);
+            F *= power;
+            entry.witnesses.emplace_back(q, 0);
+        }
+        if (F == 1 || !factored_part_suffices(n, F))
+            return false;
+
+        for (auto& [q, a] : entry.witnesses) {
+            Witness found = Witness::Useless;
+            for (a = 1; a < max_witness_base && found == Witness::Useless;)
+                found = check_witness(n, q, ++a);
+            if (found != Witness::Good)
+                return false;
+        }
+        certificate_.entries.push_back(std::move(entry));
+        return true;
+    }
+
+    bool factor_within_budget(const mpz_class& m, FactorizationOptions options, Factorization& factors) {
+        options.time_budget = remaining();
+        if (options.time_budget < 0)
+            return false;
+        factors = factorize(m, options);
+        return true;
+    }
+
+    // Whether the prime factors found could make F large enough, if all proved
+    static bool enough(const mpz_class& n, const mpz_class& n_minus_1, const Factorization& factors) {
+        mpz_class F = n_minus_1;
+        for (const auto& [part, exponent] : factors.composites) {
+            for (unsigned long e = 0; e < exponent; ++e)
+                F /= part;
+        }
+        return factored_part_suffices(n, F);
+    }
+
+    const FactorizationOptions& options_;
+    PrimalityCertificate& certificate_;
+    FactorDeadline deadline_ = no_factor_deadline;
+    std::map<mpz_class, bool> outcome_;
+};
+
+}  // namespace
+
+std::string PrimalityCertificate::serialize() const {
+    std::ostringstream out;
+    out << certificate_header << "\n";
+    for (const CertificateEntry& entry : entries) {
+        switch (entry.kind) {
+            case CertificateKind::Small: out << "S "; break;
+            case CertificateKind::NMinus1: out << "P "; break;
+            case CertificateKind::Elliptic: out << "E "; break;
+        }
+        out << entry.n.get_str(16);
+        for (const auto& [q, a] : entry.witnesses)
+            out << " " << q.get_str(16) << ":" << std::hex << a << std::dec;
+        if (entry.kind == CertificateKind::Elliptic) {
+            const EllipticProof& proof = entry.elliptic;
+            for (const mpz_class* value : {&proof.a, &proof.b, &proof.m, &proof.q, &proof.x, &proof.y})
+                out << " " << value->get_str(16);
+        }
+        out << "\n";
+    }
+    return out.str();
+}
+
+bool PrimalityCertificate::parse(const std::string& text, PrimalityCertificate& certificate) {
+    certificate.entries.clear();
+    std::istringstream in(text);
+    std::string line;
+    if (!std::getline(in, line) || line != certificate_header)
+        return false;
+
+    mpz_class a;
+    while (std::getline(in, line)) {
+        if (line.empty())
+            continue;
+        std::istringstream fields(line);
+        std::string tag, number;
+        if (!(fields >> tag >> number))
+            return false;
+        CertificateEntry entry;
+        if (tag == "S")
+            entry.kind = CertificateKind::Small;
+        else if (tag == "P")
+            entry.kind = CertificateKind::NMinus1;
+        else if (tag == "E")
+            entry.kind = CertificateKind::Elliptic;
+        else
+            return false;
+        if (entry.n.set_str(number, 16) != 0)
+            return false;
+
+        if (entry.kind == CertificateKind::Elliptic) {
+            EllipticProof& proof = entry.elliptic;
+            std::string value;
+            for (mpz_class* field : {&proof.a, &proof.b, &proof.m, &proof.q, &proof.x, &proof.y}) {
+                if (!(fields >> value) || field->set_str(value, 16) != 0)
+                    return false;
+            }
+            if (fields >> value)
+                return false;
+            certificate.entries.push_back(std::move(entry));
+            continue;
+        }
+
+        for (std::string witness; fields >> witness;) {
+            size_t colon = witness.find(':');
+            if (entry.kind != CertificateKind::NMinus1 || colon == std::string::npos)
+                return false;
+            mpz_class q;
+            if (q.set_str(witness.substr(0, colon), 16) != 0 || a.set_str(witness.substr(colon + 1), 16) != 0 ||
+                !a.fits_ulong_p())
+                return false;
+            entry.witnesses.emplace_back(std::move(q), a.get_ui());
+        }
+        certificate.entries.push_back(std::move(entry));
+    }
+    return !certificate.entries.empty();
+}
+
+bool certify_prime(const mpz_class& n, PrimalityCertificate& certificate, const FactorizationOptions& options) {
+    certificate.entries.clear();
+    Certifier certifier(options, certificate);
+    if (certifier.prove(n))
+        return true;
+    certificate.entries.clear();
+    return false;
+}
+
+bool verify_certificate(const PrimalityCertificate& certificate) {
+    if (certificate.entries.empty())
+        return false;
+    std::set<mpz_class> proven;
+    for (const CertificateEntry& entry : certificate.entries) {
+        bool valid = false;
+        switch (entry.kind) {
+            case CertificateKind::Small: valid = verify_small(entry); break;
+            case CertificateKind::NMinus1: valid = verify_n_minus_1(entry, proven); break;
+            case CertificateKind::Elliptic: valid = verify_elliptic(entry, proven); break;
+        }
+        if (!valid)
+            return false;
+        proven.insert(entry.n);
+    }
+    return true;
+}
+
+bool verify_certificate(const std::string& text, mpz_class* prime) {
+    PrimalityCertificate certificate;
+    if (!PrimalityCertificate::parse(text, certificate) || !verify_certificate(certificate))
+        return false;
+    if (prime)
+        *prime = certificate.prime();
+    return true;
+}
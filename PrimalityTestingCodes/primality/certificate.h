@@ -0,0 +1,76 @@
+#ifndef PRIMALITY_CERTIFICATE_H
+#define PRIMALITY_CERTIFICATE_H
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <gmp.h>
+#include <gmpxx.h>
+
+#include "primality/factor.h"
+
+// Primality certificates. A certificate is a list of entries, each proving
+// one prime with the help of entries before it; the last entry proves the
+// certified prime. Checking one costs a few modular exponentiations per
+// entry, far less than finding it.
+//
+// Text format, one entry per line, numbers in lowercase hex:
+//   primality-certificate 1
+//   S <n>                      n < 2^64, checked by is_prime_u64
+//   P <n> <q>:<a> <q>:<a> ...  N - 1 proof
+//   E <n> <a> <b> <m> <q> <x> <y>  elliptic curve proof
+// In an N - 1 proof every q is a prime proven earlier, F is the part of
+// n - 1 made of the listed q (each to its full power) and for every q
+//   a^(n-1) = 1 and gcd(a^((n-1)/q) - 1, n) = 1 (mod n),
+// so every prime factor of n is 1 mod F (Pocklington). That proves n prime
+// once (F + 1)^2 > n; for F^3 >= n the Brillhart-Lehmer-Selfridge test on
+// n written in base F decides the rest.
+// An elliptic curve proof (Goldwasser-Kilian, as produced by ECPP) names
+// the curve y^2 = x^3 + ax + b over Z_n with gcd(n, 6) = 1 and 4a^3 + 27b^2
+// invertible, a multiple m of a prime q > (n^(1/4) + 1)^2 proven earlier,
+// and a point P = (x, y) on it with [m/q]P != O and [m]P = O. A prime
+// p | n with p <= sqrt(n) would put a point of order q on the curve mod p,
+// whose group is smaller than q.
+
+enum class CertificateKind {
+    Small,     // S
+    NMinus1,   // P
+    Elliptic   // E
+};
+
+struct EllipticProof {
+    mpz_class a, b;   // the curve
+    mpz_class m, q;   // q | m
+    mpz_class x, y;   // the point, in [0, n)
+};
+
+struct CertificateEntry {
+    CertificateKind kind = CertificateKind::Small;
+    mpz_class n;
+    std::vector<std::pair<mpz_class, unsigned long>> witnesses;  // (q, a) for NMinus1
+    EllipticProof elliptic;                                      // for Elliptic
+};
+
+struct PrimalityCertificate {
+    std::vector<CertificateEntry> entries;
+
+    // The certified prime; the certificate must not be empty
+    const mpz_class& prime() const { return entries.back().n; }
+
+    std::string serialize() const;
+    // False (leaving `certificate` unspecified) if the text is malformed
+    static bool parse(const std::string& text, PrimalityCertificate& certificate);
+};
+
+// Builds a certificate for n, factoring n - 1 (and recursively the n - 1 of
+// its prime factors) with factorize() until the proven part F has
+// F^3 >= n. Returns false if n is composite or F stays too small within
+// options.time_budget, which covers the whole call.
+bool certify_prime(const mpz_class& n, PrimalityCertificate& certificate, const FactorizationOptions& options = {});
+
+// Checks every entry against only the entries before it. The text form also
+// checks the header and stores the certified prime in `prime` if given.
+bool verify_certificate(const PrimalityCertificate& certificate);
+bool verify_certificate(const std::string& text, mpz_class* prime = nullptr);
+
+#endif
@@ -0,0 +1,298 @@
+#include "primality/class_polynomial.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <mutex>
+
+namespace {
+
+// Precision is doubled at most this many times before giving up on a D
+constexpr int max_precision_doublings = 4;
+
+// Reduced forms (a, b, c) of discriminant d = b^2 - 4ac < 0:
+// |b| <= a <= c, and b >= 0 when |b| = a or a = c
+std::vector<std::array<long, 3>> reduced_forms(long d) {
+    std::vector<std::array<long, 3>> forms;
+    long delta = -d;
+    for (long a = 1; 3 * a * a <= delta; ++a) {
+        for (long b = -a + 1; b <= a; ++b) {
+            if (((b - d) & 1) != 0 || (b * b + delta) % (4 * a) != 0)
+                continue;
+            long c = (b * b + delta) / (4 * a);
+            if (c < a || (c == a && b < 0))
+                continue;
+            forms.push_back({a, b, c});
+        }
+    }
+    return forms;
+}
+
+std::vector<EcppDiscriminant> build_discriminants() {
+    const long limit = max_ecpp_discriminant;
+
+    // h(-delta) for every delta, one pass over all reduced forms
+    std::vector<unsigned> class_number(limit + 1, 0);
+    for (long a = 1; 3 * a * a <= limit; ++a) {
+        for (long b = 0; b <= a; ++b) {
+            for (long c = a; 4 * a * c - b * b <= limit; ++c) {
+                long delta = 4 * a * c - b * b;
+                bool one_sign = b == 0 || b == a || a == c;
+                class_number[delta] += one_sign ? 1 : 2;
+            }
+        }
+    }
+
+    std::vector<bool> squarefree(limit + 1, true);
+    for (long p = 2; p * p <= limit; ++p) {
+        for (long m = p * p; m <= limit; m += p * p)
+            squarefree[m] = false;
+    }
+
+    // Fundamental: -delta = 1 mod 4 squarefree, or 4m with m = 2, 3 mod 4 squarefree
+    std::vector<EcppDiscriminant> table;
+    for (long delta = 3; delta <= limit; ++delta) {
+        bool fundamental = (delta % 4 == 3 && squarefree[delta]) ||
+                           (delta % 4 == 0 && (delta / 4 % 4 == 1 || delta / 4 % 4 == 2) && squarefree[delta / 4]);
+        if (fundamental)
+            table.push_back({-delta, class_number[delta]});
+    }
+    std::stable_sort(table.begin(), table.end(), [](const EcppDiscriminant& x, const EcppDiscriminant& y) {
+        return x.class_number < y.class_number;
+    });
+    return table;
+}
+
+struct Complex {
+    mpf_class re, im;
+    explicit Complex(mp_bitcnt_t prec) : re(0, prec), im(0, prec) {}
+};
+
+// Evaluation of j at `prec` bits, with scratch sized once per D
+class JEvaluator {
+public:
+    explicit JEvaluator(mp_bitcnt_t prec)
+        : prec_(prec), pi_(0, prec), eps_(0, prec), t1_(0, prec), t2_(0, prec), t3_(0, prec) {
+        mpf_div_2exp(eps_.get_mpf_t(), mpf_class(1, prec).get_mpf_t(), prec + 8);
+        compute_pi();
+    }
+
+    // j((-b + sqrt(-delta)) / 2a)
+    Complex j(long delta, long a, long b) {
+        // q = e^(2 pi i tau) = e^(-pi sqrt(delta) / a) (cos(pi b / a) - i sin(pi b / a))
+        mpf_class r(delta, prec_);
+        r = sqrt(r) * pi_ / a;
+        mpf_class magnitude = exp_neg(r);
+        mpf_class theta(pi_ * b / a, prec_);
+        mpf_class c(0, prec_), s(0, prec_);
+        cos_sin(c, s, theta);
+        Complex q(prec_);
+        q.re = magnitude * c;
+        q.im = -magnitude * s;
+
+        // f = Delta(2 tau) / Delta(tau) = q (eta_product(q^2) / eta_product(q))^24,
+        // and j = (256 f + 1)^3 / f
+        double bits_per_power = M_PI * std::sqrt(static_cast<double>(delta)) / a / M_LN2;
+        Complex q2(prec_);
+        mul(q2, q, q);
+        Complex numerator = eta_product(q2, 2 * bits_per_power);
+        Complex denominator = eta_product(q, bits_per_power);
+        Complex f(prec_);
+        div(f, numerator, denominator);
+        Complex power(prec_);
+        mul(power, f, f);           // ^2
+        mul(power, power, f);       // ^3
+        mul(power, power, power);   // ^6
+        mul(power, power, power);   // ^12
+        mul(power, power, power);   // ^24
+        mul(f, power, q);
+
+        Complex g(prec_);
+        g.re = 256 * f.re + 1;
+        g.im = 256 * f.im;
+        Complex cube(prec_);
+        mul(cube, g, g);
+        mul(cube, cube, g);
+        Complex result(prec_);
+        div(result, cube, f);
+        return result;
+    }
+
+private:
+    // Gauss-Legendre
+    void compute_pi() {
+        mpf_class a(1, prec_), b(0.5, prec_), t(0.25, prec_), p(1, prec_), next(0, prec_);
+        b = sqrt(b);
+        for (mp_bitcnt_t bits = 1; bits < 2 * prec_; bits *= 2) {
+            next = (a + b) / 2;
+            b = sqrt(a * b);
+            t1_ = a - next;
+            t -= p * t1_ * t1_;
+            a = next;
+            p *= 2;
+        }
+        pi_ = (a + b) * (a + b) / (4 * t);
+    }
+
+    // e^-x for x > 0: the series for x / 2^s, then s squarings
+    mpf_class exp_neg(const mpf_class& x) {
+        mpf_class y(x, prec_);
+        int halvings = 0;
+        while (y > 0.001) {
+            y /= 2;
+            ++halvings;
+        }
+        mpf_class sum(1, prec_), term(1, prec_);
+        for (unsigned long k = 1; abs(term) > eps_; ++k) {
+            term = -term * y / k;
+            sum += term;
+        }
+        for (int i = 0; i < halvings; ++i)
+            sum *= sum;
+        return sum;
+    }
+
+    // cos and sin of |theta| <= pi by their series
+    void cos_sin(mpf_class& c, mpf_class& s, const mpf_class& theta) {
+        mpf_class term(1, prec_);
+        c = 0;
+        s = 0;
+        for (unsigned long k = 0; k < 4 || abs(term) > eps_; ++k) {
+            switch (k % 4) {
+                case 0: c += term; break;
+                case 1: s += term; break;
+                case 2: c -= term; break;
+                case 3: s -= term; break;
+            }
+            term = term * theta / (k + 1);
+        }
+    }
+
+    // prod (1 - z^n) = 1 + sum_(k >= 1) (-1)^k (z^(k(3k-1)/2) + z^(k(3k+1)/2)),
+    // where |z| = 2^-bits_per_power
+    Complex eta_product(const Complex& z, double bits_per_power) {
+        Complex sum(prec_), a(prec_), zk(prec_), step(prec_), z3(prec_), b(prec_);
+        sum.re = 1;
+        a = z;       // z^(k(3k-1)/2)
+        zk = z;      // z^k
+        mul(z3, z, z);
+        mul(z3, z3, z);
+        mul(step, z3, z);  // z^(3k+1)
+        double exponent = 1;
+        for (long k = 1; exponent * bits_per_power < prec_ + 16; ++k) {
+            mul(b, a, zk);
+            if (k % 2 == 0) {
+                sum.re += a.re + b.re;
+                sum.im += a.im + b.im;
+            } else {
+                sum.re -= a.re + b.re;
+                sum.im -= a.im + b.im;
+            }
+            mul(a, a, step);
+            mul(step, step, z3);
+            mul(zk, zk, z);
+            exponent += 3 * k + 1;
+        }
+        return sum;
+    }
+
+    // r = x * y and r = x / y; r may alias x or y
+    void mul(Complex& r, const Complex& x, const Complex& y) {
+        t1_ = x.re * y.re - x.im * y.im;
+        t2_ = x.re * y.im + x.im * y.re;
+        r.re = t1_;
+        r.im = t2_;
+    }
+
+    void div(Complex& r, const Complex& x, const Complex& y) {
+        t3_ = y.re * y.re + y.im * y.im;
+        t1_ = (x.re * y.re + x.im * y.im) / t3_;
+        t2_ = (x.im * y.re - x.re * y.im) / t3_;
+        r.re = t1_;
+        r.im = t2_;
+    }
+
+    mp_bitcnt_t prec_;
+    mpf_class pi_, eps_;
+    mpf_class t1_, t2_, t3_;
+};
+
+// H_D from the roots at `prec` bits, or false if a coefficient does not round
+// cleanly to an integer
+bool compute_class_polynomial(std::vector<mpz_class>& result, long d,
+                              const std::vector<std::array<long, 3>>& forms, mp_bitcnt_t prec) {
+    JEvaluator evaluator(prec);
+    std::vector<Complex> poly(1, Complex(prec));
+    poly[0].re = 1;
+    mpf_class re(0, prec), im(0, prec);
+    for (const auto& form : forms) {
+        Complex j = evaluator.j(-d, form[0], form[1]);
+        // poly *= x - j, top down: new[i] = old[i - 1] - j old[i]
+        poly.emplace_back(prec);
+        for (size_t i = poly.size() - 1; i > 0; --i) {
+            re = poly[i - 1].re - (j.re * poly[i].re - j.im * poly[i].im);
+            im = poly[i - 1].im - (j.re * poly[i].im + j.im * poly[i].re);
+            poly[i].re = re;
+            poly[i].im = im;
+        }
+        re = -(j.re * poly[0].re - j.im * poly[0].im);
+        im = -(j.re * poly[0].im + j.im * poly[0].re);
+        poly[0].re = re;
+        poly[0].im = im;
+    }
+
+    // The exact coefficients are integers; anything far from one means the
+    // precision was too low
+    const mpf_class tolerance(0.01, prec);
+    result.assign(poly.size(), 0);
+    for (size_t i = 0; i < poly.size(); ++i) {
+        re = poly[i].re + 0.5;
+        mpf_floor(re.get_mpf_t(), re.get_mpf_t());
+        if (abs(poly[i].re - re) > tolerance || abs(poly[i].im) > tolerance)
+            return false;
+        mpz_set_f(result[i].get_mpz_t(), re.get_mpf_t());
+    }
+    return true;
+}
+
+std::vector<mpz_class> class_polynomial(long d) {
+    std::vector<std::array<long, 3>> forms = reduced_forms(d);
+
+    // log2 of the largest coefficient is at most sum log2(|j| + 1), and
+    // |j((-b + sqrt(d)) / 2a)| is about e^(pi sqrt(|d|) / a)
+    double bits = 0;
+    for (const auto& form : forms)
+        bits += M_PI * std::sqrt(static_cast<double>(-d)) / form[0] / M_LN2 + 1;
+    mp_bitcnt_t prec = static_cast<mp_bitcnt_t>(bits) + 64;
+
+    std::vector<mpz_class> result;
+    for (int attempt = 0; attempt <= max_precision_doublings; ++attempt, prec *= 2) {
+        if (compute_class_polynomial(result, d, forms, prec))
+            return result;
+    }
+    result.clear();
+    return result;
+}
+
+}  // namespace
+
+const std::vector<EcppDiscriminant>& ecpp_discriminants() {
+    static const std::vector<EcppDiscriminant> table = build_discriminants();
+    return table;
+}
+
+const std::vector<mpz_class>& hilbert_class_polynomial(long d) {
+    static std::mutex mutex;
+    static std::map<long, std::vector<mpz_class>> cache;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = cache.find(d);
+        if (found != cache.end())
+            return found->second;
+    }
+    // Computed outside the lock; map nodes do not move, so the reference lasts
+    std::vector<mpz_class> poly = class_polynomial(d);
+    std::lock_guard<std::mutex> lock(mutex);
+    return cache.emplace(d, std::move(poly)).first->second;
+}
@@ -0,0 +1,31 @@
+#ifndef PRIMALITY_CLASS_POLYNOMIAL_H
+#define PRIMALITY_CLASS_POLYNOMIAL_H
+
+#include <vector>
+#include <gmp.h>
+#include <gmpxx.h>
+
+// Imaginary quadratic discriminants and Hilbert class polynomials for the
+// ECPP down-run (see ecpp.h).
+
+// Largest |D| in the discriminant table
+constexpr long max_ecpp_discriminant = 200000;
+
+struct EcppDiscriminant {
+    long d = 0;                  // fundamental discriminant, negative
+    unsigned class_number = 0;   // h(D), the degree of H_D
+};
+
+// Every fundamental D with -max_ecpp_discriminant <= D < 0, by class number
+// then |D|. Class numbers are counted from the reduced forms of all
+// discriminants at once; the table is built on first use and shared.
+const std::vector<EcppDiscriminant>& ecpp_discriminants();
+
+// The Hilbert class polynomial H_D, monic with integer coefficients, constant
+// term first. Its roots are j((-b + sqrt(D)) / 2a) over the reduced forms
+// (a, b, c) of D, evaluated in floating point with enough bits for the
+// coefficients to round exactly; that precision is doubled until they do.
+// Each D is computed once and cached; safe to call from several threads.
+const std::vector<mpz_class>& hilbert_class_polynomial(long d);
+
+#endif
@@ -0,0 +1,456 @@
+#include "primality/ecpp.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <map>
+#include <vector>
+
+#include "primality/class_polynomial.h"
+#include "primality/elliptic_curve.h"
+#include "primality/fixed_width.h"
+#include "primality/primality.h"
+
+namespace {
+
+// Discriminants handed to the pool at once, per worker
+constexpr size_t discriminants_per_worker = 2;
+// Points tried on a curve, and shifts tried while splitting H_D mod n,
+// before a step gives up; for prime n both succeed within a few
+constexpr unsigned long max_points = 64;
+constexpr unsigned long max_split_shifts = 128;
+// Search limit for a small non-residue mod n
+constexpr unsigned long max_nonresidue = 1000;
+
+// One step of the down-run: the order m = kq of a curve over Z_n with CM by D
+struct Step {
+    mpz_class n;
+    long d = 0;
+    mpz_class m, q;
+};
+
+// r^2 = a mod p by Tonelli-Shanks, or false if there is no root (also the
+// verdict when p turns out not to be prime)
+bool sqrt_mod(mpz_class& r, const mpz_class& a, const mpz_class& p) {
+    mpz_class x;
+    mpz_mod(x.get_mpz_t(), a.get_mpz_t(), p.get_mpz_t());
+    if (x == 0) {
+        r = 0;
+        return true;
+    }
+    mpz_class odd = p - 1;
+    mp_bitcnt_t s = mpz_scan1(odd.get_mpz_t(), 0);
+    mpz_tdiv_q_2exp(odd.get_mpz_t(), odd.get_mpz_t(), s);
+
+    unsigned long z = 2;
+    while (mpz_ui_kronecker(z, p.get_mpz_t()) != -1) {
+        if (++z > max_nonresidue)
+            return false;
+    }
+    mpz_class c, t, e;
+    mpz_class base = z;
+    mpz_powm(c.get_mpz_t(), base.get_mpz_t(), odd.get_mpz_t(), p.get_mpz_t());
+    mpz_powm(t.get_mpz_t(), x.get_mpz_t(), odd.get_mpz_t(), p.get_mpz_t());
+    e = (odd + 1) / 2;
+    mpz_powm(r.get_mpz_t(), x.get_mpz_t(), e.get_mpz_t(), p.get_mpz_t());
+
+    mpz_class b, u;
+    for (mp_bitcnt_t m = s; t != 1;) {
+        // Least i with t^(2^i) = 1
+        mp_bitcnt_t i = 0;
+        for (u = t; u != 1 && i < m; ++i)
+            u = u * u % p;
+        if (i == m)
+            return false;
+        b = c;
+        for (mp_bitcnt_t j = 0; j + i + 1 < m; ++j)
+            b = b * b % p;
+        m = i;
+        c = b * b % p;
+        t = t * c % p;
+        r = r * b % p;
+    }
+    return (r * r - x) % p == 0;
+}
+
+// Cornacchia's algorithm for u^2 + |d| v^2 = 4n, d = 0, 1 mod 4 and |d| < 4n
+bool cornacchia(mpz_class& u, mpz_class& v, long d, const mpz_class& n) {
+    mpz_class root;
+    if (!sqrt_mod(root, mpz_class(d), n))
+        return false;
+    if (mpz_odd_p(root.get_mpz_t()) != (d & 1))
+        root = n - root;
+
+    mpz_class a = 2 * n, b = root, limit, t;
+    limit = 4 * n;
+    mpz_sqrt(limit.get_mpz_t(), limit.get_mpz_t());
+    while (b > limit) {
+        t = a % b;
+        a = b;
+        b = t;
+    }
+    t = 4 * n - b * b;
+    if (!mpz_divisible_ui_p(t.get_mpz_t(), static_cast<unsigned long>(-d)))
+        return false;
+    t /= -d;
+    if (!mpz_perfect_square_p(t.get_mpz_t()))
+        return false;
+    u = b;
+    mpz_sqrt(v.get_mpz_t(), t.get_mpz_t());
+    return true;
+}
+
+// The first order for D that is a smooth part times a large probable prime
+bool try_discriminant(Step& step, const mpz_class& n, long d, const mpz_class& primorial) {
+    if (mpz_si_kronecker(d, n.get_mpz_t()) != 1)
+        return false;
+    mpz_class u, v;
+    if (!cornacchia(u, v, d, n))
+        return false;
+
+    // Traces of the curves with CM by D: +-u, and for the extra units of
+    // D = -4 and -3, +-2v and +-(u +- 3v) / 2
+    std::vector<mpz_class> traces = {u, -u};
+    if (d == -4) {
+        traces.push_back(2 * v);
+        traces.push_back(-2 * v);
+    } else if (d == -3) {
+        for (int sign : {1, -1}) {
+            mpz_class t = (u + sign * 3 * v) / 2;
+            traces.push_back(t);
+            traces.push_back(-t);
+        }
+    }
+
+    mpz_class m, q, g;
+    for (const mpz_class& trace : traces) {
+        m = n + 1 - trace;
+        // Strip every prime below the bound: g collects them, one power at a time
+        q = m;
+        g = primorial % q;
+        mpz_gcd(g.get_mpz_t(), g.get_mpz_t(), q.get_mpz_t());
+        while (g > 1) {
+            mpz_divexact(q.get_mpz_t(), q.get_mpz_t(), g.get_mpz_t());
+            mpz_gcd(g.get_mpz_t(), g.get_mpz_t(), q.get_mpz_t());
+        }
+        if (q == m || !exceeds_hasse_bound(q, n) || !is_bpsw_prime(q.get_mpz_t()))
+            continue;
+        step.n = n;
+        step.d = d;
+        step.m = m;
+        step.q = q;
+        return true;
+    }
+    return false;
+}
+
+// Polynomials over Z_n, constant term first, with no trailing zeros
+class PolynomialRing {
+public:
+    using Poly = std::vector<mpz_class>;
+
+    explicit PolynomialRing(const mpz_class& n) : n_(n) {}
+
+    static long degree(const Poly& a) { return static_cast<long>(a.size()) - 1; }
+
+    void trim(Poly& a) const {
+        for (mpz_class& c : a)
+            mpz_mod(c.get_mpz_t(), c.get_mpz_t(), n_.get_mpz_t());
+        while (!a.empty() && a.back() == 0)
+            a.pop_back();
+    }
+
+    // False if the leading coefficient is not invertible mod n
+    bool make_monic(Poly& a) const {
+        if (a.empty() || a.back() == 1)
+            return true;
+        mpz_class inverse;
+        if (!mpz_invert(inverse.get_mpz_t(), a.back().get_mpz_t(), n_.get_mpz_t()))
+            return false;
+        for (mpz_class& c : a)
+            c = c * inverse % n_;
+        return true;
+    }
+
+    // a = a mod m for a monic m
+    void reduce(Poly& a, const Poly& m) const {
+        long dm = degree(m);
+        for (long i = degree(a); i >= dm; --i) {
+            mpz_mod(a[i].get_mpz_t(), a[i].get_mpz_t(), n_.get_mpz_t());
+            if (a[i] == 0)
+                continue;
+            for (long j = 0; j < dm; ++j)
+                a[i - dm + j] -= a[i] * m[j];
+        }
+        if (degree(a) >= dm)
+            a.resize(dm);
+        trim(a);
+    }
+
+    void mulmod(Poly& r, const Poly& a, const Poly& b, const Poly& m) const {
+        Poly product(a.empty() || b.empty() ? 0 : a.size() + b.size() - 1);
+        for (size_t i = 0; i < a.size(); ++i) {
+            for (size_t j = 0; j < b.size(); ++j)
+                product[i + j] += a[i] * b[j];
+        }
+        reduce(product, m);
+        r = std::move(product);
+    }
+
+    // base^e mod m, left to right
+    Poly powmod(const Poly& base, const mpz_class& e, const Poly& m) const {
+        Poly r = {1};
+        reduce(r, m);
+        for (mp_bitcnt_t bit = mpz_sizeinbase(e.get_mpz_t(), 2); bit-- > 0;) {
+            mulmod(r, r, r, m);
+            if (mpz_tstbit(e.get_mpz_t(), bit))
+                mulmod(r, r, base, m);
+        }
+        return r;
+    }
+
+    // Monic gcd, or false if a leading coefficient is not invertible
+    bool gcd(Poly& r, Poly a, Poly b) const {
+        trim(a);
+        trim(b);
+        while (!b.empty()) {
+            if (!make_monic(b))
+                return false;
+            reduce(a, b);
+            std::swap(a, b);
+        }
+        r = std::move(a);
+        return make_monic(r);
+    }
+
+    // A root of h, which splits into distinct linear factors mod prime n:
+    // gcd with x^n - x keeps the linear factors, and gcd with
+    // (x + delta)^((n - 1) / 2) - 1 splits them for most delta
+    bool root(mpz_class& result, const Poly& h) const {
+        Poly g = h;
+        trim(g);
+        if (!make_monic(g) || degree(g) < 1)
+            return false;
+        if (degree(g) > 1) {
+            Poly x = {0, 1};
+            Poly t = powmod(x, n_, g);
+            t.resize(std::max<size_t>(t.size(), 2));
+            t[1] -= 1;
+            if (!gcd(g, g, t))
+                return false;
+        }
+        mpz_class half = (n_ - 1) / 2;
+        for (unsigned long delta = 0; degree(g) > 1; ++delta) {
+            if (delta == max_split_shifts || degree(g) < 1)
+                return false;
+            Poly t = powmod(Poly{delta, 1}, half, g);
+            t.resize(std::max<size_t>(t.size(), 1));
+            t[0] -= 1;
+            Poly d;
+            if (!gcd(d, g, t))
+                return false;
+            if (degree(d) >= 1 && degree(d) < degree(g))
+                g = std::move(d);
+        }
+        if (degree(g) != 1)
+            return false;
+        result = n_ - g[0];
+        mpz_mod(result.get_mpz_t(), result.get_mpz_t(), n_.get_mpz_t());
+        return true;
+    }
+
+private:
+    mpz_class n_;
+};
+
+// Smallest g >= 2 that is not a square mod n, and with `cube` not a cube
+// either (n = 1 mod 3 then), or 0 if there is none below max_nonresidue
+unsigned long twist_generator(const mpz_class& n, bool cube) {
+    mpz_class e = (n - 1) / 3, g, r;
+    for (unsigned long candidate = 2; candidate <= max_nonresidue; ++candidate) {
+        if (mpz_ui_kronecker(candidate, n.get_mpz_t()) != -1)
+            continue;
+        g = candidate;
+        if (cube) {
+            mpz_powm(r.get_mpz_t(), g.get_mpz_t(), e.get_mpz_t(), n.get_mpz_t());
+            if (r == 1)
+                continue;
+        }
+        return candidate;
+    }
+    return 0;
+}
+
+// A curve of order step.m over Z_n and a point P with [k]P != O and
+// [m]P = O, as an E entry. The curves with CM by D are the twists of one
+// curve with j a root of H_D: the quadratic twist by a non-residue, or for
+// D = -3, -4 (j = 0, 1728) y^2 = x^3 + g^i and y^2 = x^3 + g^i x over a
+// generator g of the sextic or quartic residue classes. A random point
+// whose order does not divide m rules a twist out.
+bool build_entry(CertificateEntry& entry, const Step& step) {
+    const mpz_class& n = step.n;
+    mpz_class k = step.m / step.q;
+
+    std::vector<std::pair<mpz_class, mpz_class>> curves;
+    if (step.d == -3 || step.d == -4) {
+        unsigned long g = twist_generator(n, step.d == -3);
+        if (g == 0)
+            return false;
+        mpz_class power = 1;
+        for (int i = 0; i < (step.d == -3 ? 6 : 4); ++i, power = power * g % n) {
+            if (step.d == -3)
+                curves.emplace_back(0, power);
+            else
+                curves.emplace_back(power, 0);
+        }
+    } else {
+        mpz_class j;
+        if (!PolynomialRing(n).root(j, hilbert_class_polynomial(step.d)))
+            return false;
+        // y^2 = x^3 + 3cx + 2c with c = j / (1728 - j) has j-invariant j
+        mpz_class c = 1728 - j, inverse;
+        if (!mpz_invert(inverse.get_mpz_t(), c.get_mpz_t(), n.get_mpz_t()) || j == 0)
+            return false;
+        c = j * inverse % n;
+        unsigned long g = twist_generator(n, false);
+        if (g == 0)
+            return false;
+        curves.emplace_back(3 * c % n, 2 * c % n);
+        curves.emplace_back(3 * c * g * g % n, 2 * c * g * g * g % n);
+    }
+
+    mpz_class rhs;
+    for (const auto& [a, b] : curves) {
+        EllipticCurveModN curve(n, a, b);
+        if (!curve.nonsingular())
+            continue;
+        for (unsigned long x = 0, tried = 0; tried < max_points; ++x) {
+            rhs = (mpz_class(x) * x + a) * x + b;
+            if (mpz_kronecker(rhs.get_mpz_t(), n.get_mpz_t()) != 1)
+                continue;
+            ++tried;
+            CurvePoint p;
+            p.x = x;
+            if (!sqrt_mod(p.y, rhs, n))
+                return false;
+
+            CurvePoint kp, mp;
+            if (!curve.multiply(kp, p, k))
+                return false;
+            if (kp.infinity)
+                continue;
+            if (!curve.multiply(mp, kp, step.q))
+                return false;
+            if (!mp.infinity)
+                break;  // the order of p does not divide m: the other curve
+
+            entry.kind = CertificateKind::Elliptic;
+            entry.n = n;
+            entry.witnesses.clear();
+            mpz_mod(entry.elliptic.a.get_mpz_t(), a.get_mpz_t(), n.get_mpz_t());
+            mpz_mod(entry.elliptic.b.get_mpz_t(), b.get_mpz_t(), n.get_mpz_t());
+            entry.elliptic.m = step.m;
+            entry.elliptic.q = step.q;
+            entry.elliptic.x = p.x;
+            entry.elliptic.y = p.y;
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+bool ecpp_certify(const mpz_class& n, PrimalityCertificate& certificate, const EcppOptions& options) {
+    certificate.entries.clear();
+    if (n < 2)
+        return false;
+    if (mpz_sizeinbase(n.get_mpz_t(), 2) > 64 && !is_bpsw_prime(n.get_mpz_t()))
+        return false;
+
+    auto start = std::chrono::steady_clock::now();
+    auto expired = [&] {
+        return options.time_budget > 0 &&
+               std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > options.time_budget;
+    };
+
+    ThreadPool& pool = options.pool ? *options.pool : default_thread_pool();
+    const std::vector<EcppDiscriminant>& table = ecpp_discriminants();
+    size_t candidates = 0;
+    while (candidates < table.size() && table[candidates].class_number <= options.max_class_number)
+        ++candidates;
+    // Stripping an order costs a division by the primorial of the bound, so
+    // the bound grows with n: bits(n)^2, rounded down to a power of two
+    std::map<unsigned long, mpz_class> primorials;
+    auto primorial_for = [&](const mpz_class& m) -> const mpz_class& {
+        unsigned long bits = mpz_sizeinbase(m.get_mpz_t(), 2);
+        unsigned long bound = std::bit_floor(std::min(options.smoothness_bound, bits * bits));
+        mpz_class& primorial = primorials[bound];
+        if (primorial == 0)
+            mpz_primorial_ui(primorial.get_mpz_t(), bound);
+        return primorial;
+    };
+
+    // Down-run. Each batch of discriminants is tested in parallel and the
+    // first in table order that works is kept, so the chain does not depend
+    // on the number of workers. A step that finds nothing backs up one level
+    // and resumes the search there after the discriminant it used.
+    std::vector<Step> chain;
+    std::vector<size_t> used;  // table index of each step's D
+    mpz_class current = n;
+    size_t resume = 0;
+    size_t batch = std::max<size_t>(1, pool.size() * discriminants_per_worker);
+    while (mpz_sizeinbase(current.get_mpz_t(), 2) > 64) {
+        const mpz_class& primorial = primorial_for(current);
+        bool found = false;
+        for (size_t first = resume; first < candidates && !found; first += batch) {
+            if (expired())
+                return false;
+            size_t count = std::min(batch, candidates - first);
+            std::vector<Step> steps(count);
+            std::vector<unsigned char> ok(count, 0);
+            std::vector<double> costs(count, 1.0);
+            pool.run(costs, [&](size_t i, unsigned) {
+                ok[i] = try_discriminant(steps[i], current, table[first + i].d, primorial);
+            });
+            for (size_t i = 0; i < count && !found; ++i) {
+                if (ok[i]) {
+                    chain.push_back(std::move(steps[i]));
+                    used.push_back(first + i);
+                    found = true;
+                }
+            }
+        }
+        if (found) {
+            current = chain.back().q;
+            resume = 0;
+            continue;
+        }
+        if (chain.empty())
+            return false;
+        resume = used.back() + 1;
+        chain.pop_back();
+        used.pop_back();
+        current = chain.empty() ? n : chain.back().q;
+    }
+    if (!is_prime_u64(mpz_get_ui(current.get_mpz_t())))
+        return false;
+
+    // Curves for every step at once, largest first since they cost most
+    std::vector<CertificateEntry> entries(chain.size());
+    std::vector<unsigned char> built(chain.size(), 0);
+    std::vector<double> costs(chain.size());
+    for (size_t i = 0; i < chain.size(); ++i) {
+        double bits = static_cast<double>(mpz_sizeinbase(chain[i].n.get_mpz_t(), 2));
+        costs[i] = bits * bits * bits;
+    }
+    pool.run(costs, [&](size_t i, unsigned) { built[i] = build_entry(entries[i], chain[i]); });
+    if (std::find(built.begin(), built.end(), 0) != built.end())
+        return false;
+
+    // The last q first, then each step on top of the one below it
+    certificate.entries.push_back({CertificateKind::Small, current, {}, {}});
+    for (size_t i = chain.size(); i-- > 0;)
+        certificate.entries.push_back(std::move(entries[i]));
+    return true;
+}
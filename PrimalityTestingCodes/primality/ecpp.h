@@ -0,0 +1,33 @@
+#ifndef PRIMALITY_ECPP_H
+#define PRIMALITY_ECPP_H
+
+#include <gmp.h>
+#include <gmpxx.h>
+
+#include "primality/certificate.h"
+#include "primality/thread_pool.h"
+
+// Elliptic curve primality proving, after Atkin and Morain. The down-run
+// looks for a discriminant D in the class polynomial table with
+// 4n = u^2 + |D| v^2 and a curve order m = n + 1 -+ u (more for D = -3, -4)
+// that is a small smooth part times a probable prime q > (n^(1/4) + 1)^2,
+// then continues with q until it fits in 64 bits. Afterwards every step gets
+// its curve, with j a root of H_D mod n, and a point of order q. The result
+// is an ordinary certificate (see certificate.h) with one E entry per step
+// above an S entry for the last q.
+
+struct EcppOptions {
+    double time_budget = 0;                        // seconds for the down-run; <= 0 means no limit
+    unsigned max_class_number = 64;                // discriminants tried, by class number
+    unsigned long smoothness_bound = 1ul << 20;    // cap on the primes stripped from curve orders
+    ThreadPool* pool = nullptr;                    // the default pool if null
+};
+
+// Builds a certificate for n. Returns false if n is composite, if the
+// down-run runs out of discriminants even after backing up, or if the budget
+// runs out. Each step of the down-run tests a batch of discriminants at once
+// on the pool, and the curves of all steps are built in parallel once the
+// chain is known.
+bool ecpp_certify(const mpz_class& n, PrimalityCertificate& certificate, const EcppOptions& options = {});
+
+#endif
@@ -0,0 +1,110 @@
+#include "primality/elliptic_curve.h"
+
+EllipticCurveModN::EllipticCurveModN(const mpz_class& n, const mpz_class& a, const mpz_class& b) : n_(n) {
+    mpz_mod(a_.get_mpz_t(), a.get_mpz_t(), n_.get_mpz_t());
+    mpz_mod(b_.get_mpz_t(), b.get_mpz_t(), n_.get_mpz_t());
+}
+
+bool EllipticCurveModN::nonsingular() const {
+    mpz_class d = 4 * a_ * a_ * a_ + 27 * b_ * b_;
+    mpz_gcd(d.get_mpz_t(), d.get_mpz_t(), n_.get_mpz_t());
+    return d == 1;
+}
+
+bool EllipticCurveModN::contains(const CurvePoint& p) const {
+    if (p.infinity)
+        return true;
+    mpz_class d = p.y * p.y - (p.x * p.x + a_) * p.x - b_;
+    return mpz_divisible_p(d.get_mpz_t(), n_.get_mpz_t()) != 0;
+}
+
+bool EllipticCurveModN::invert(const mpz_class& d) {
+    if (mpz_invert(inverse_.get_mpz_t(), d.get_mpz_t(), n_.get_mpz_t()))
+        return true;
+    mpz_gcd(factor_.get_mpz_t(), d.get_mpz_t(), n_.get_mpz_t());
+    return false;
+}
+
+bool EllipticCurveModN::add(CurvePoint& r, const CurvePoint& p, const CurvePoint& q) {
+    if (p.infinity) {
+        r = q;
+        return true;
+    }
+    if (q.infinity) {
+        r = p;
+        return true;
+    }
+    if (p.x == q.x) {
+        // q = -p or q = p mod n; anything else differs between the factors of n
+        t_ = p.y + q.y;
+        if (t_ == 0 || t_ == n_) {
+            r.infinity = true;
+            return true;
+        }
+        if (p.y == q.y)
+            return dbl(r, p);
+        t_ = p.y - q.y;
+        invert(t_);
+        return false;
+    }
+
+    t_ = q.x - p.x;
+    if (!invert(t_))
+        return false;
+    lambda_ = (q.y - p.y) * inverse_;
+    mpz_mod(lambda_.get_mpz_t(), lambda_.get_mpz_t(), n_.get_mpz_t());
+    mpz_class x = lambda_ * lambda_ - p.x - q.x;
+    mpz_mod(x.get_mpz_t(), x.get_mpz_t(), n_.get_mpz_t());
+    t_ = lambda_ * (p.x - x) - p.y;
+    mpz_mod(r.y.get_mpz_t(), t_.get_mpz_t(), n_.get_mpz_t());
+    r.x = std::move(x);
+    r.infinity = false;
+    return true;
+}
+
+bool EllipticCurveModN::dbl(CurvePoint& r, const CurvePoint& p) {
+    if (p.infinity || p.y == 0) {
+        r.infinity = true;
+        return true;
+    }
+    t_ = 2 * p.y;
+    if (!invert(t_))
+        return false;
+    lambda_ = (3 * p.x * p.x + a_) * inverse_;
+    mpz_mod(lambda_.get_mpz_t(), lambda_.get_mpz_t(), n_.get_mpz_t());
+    mpz_class x = lambda_ * lambda_ - 2 * p.x;
+    mpz_mod(x.get_mpz_t(), x.get_mpz_t(), n_.get_mpz_t());
+    t_ = lambda_ * (p.x - x) - p.y;
+    mpz_mod(r.y.get_mpz_t(), t_.get_mpz_t(), n_.get_mpz_t());
+    r.x = std::move(x);
+    r.infinity = false;
+    return true;
+}
+
+bool EllipticCurveModN::multiply(CurvePoint& r, const CurvePoint& p, const mpz_class& k) {
+    if (k == 0 || p.infinity) {
+        r = CurvePoint();
+        r.infinity = true;
+        return true;
+    }
+    // Left to right; each add is by p, which add() handles when it meets +-p
+    CurvePoint acc = p;
+    for (mp_bitcnt_t bit = mpz_sizeinbase(k.get_mpz_t(), 2) - 1; bit-- > 0;) {
+        if (!dbl(acc, acc))
+            return false;
+        if (mpz_tstbit(k.get_mpz_t(), bit) && !add(acc, acc, p))
+            return false;
+    }
+    r = std::move(acc);
+    return true;
+}
+
+bool exceeds_hasse_bound(const mpz_class& q, const mpz_class& n) {
+    mpz_class s;
+    mpz_sqrt(s.get_mpz_t(), q.get_mpz_t());
+    if (s < 1)
+        return false;
+    s -= 1;
+    mpz_pow_ui(s.get_mpz_t(), s.get_mpz_t(), 4);
+    return s > n;
+}
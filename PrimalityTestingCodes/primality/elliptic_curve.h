@@ -0,0 +1,51 @@
+#ifndef PRIMALITY_ELLIPTIC_CURVE_H
+#define PRIMALITY_ELLIPTIC_CURVE_H
+
+#include <gmp.h>
+#include <gmpxx.h>
+
+// A point of y^2 = x^3 + ax + b over Z_n in affine coordinates, or the point
+// at infinity O
+struct CurvePoint {
+    mpz_class x, y;
+    bool infinity = false;
+};
+
+// The curve y^2 = x^3 + ax + b over Z_n for n coprime to 6, with the chord
+// and tangent rules in affine coordinates and one inversion per step. n need
+// not be prime: a step whose denominator is not invertible mod n fails rather
+// than guess, so every result that is returned reduces mod each prime p | n
+// to the same computation on the curve over F_p, as Goldwasser-Kilian needs.
+class EllipticCurveModN {
+public:
+    EllipticCurveModN(const mpz_class& n, const mpz_class& a, const mpz_class& b);
+
+    // Whether 4a^3 + 27b^2 is invertible mod n
+    bool nonsingular() const;
+    // Whether p is O or satisfies the equation mod n
+    bool contains(const CurvePoint& p) const;
+
+    // r = p + q, r = 2p and r = [k]p for k >= 0. Each returns false, leaving r
+    // unspecified, if a denominator is not invertible mod n; the gcd of that
+    // denominator with n (a proper factor, or n) is then in factor().
+    bool add(CurvePoint& r, const CurvePoint& p, const CurvePoint& q);
+    bool dbl(CurvePoint& r, const CurvePoint& p);
+    bool multiply(CurvePoint& r, const CurvePoint& p, const mpz_class& k);
+
+    const mpz_class& factor() const { return factor_; }
+
+private:
+    // inverse_ = d^-1 mod n, or false with factor_ = gcd(d, n)
+    bool invert(const mpz_class& d);
+
+    mpz_class n_, a_, b_;
+    mpz_class factor_;
+    mpz_class inverse_, lambda_, t_;  // scratch
+};
+
+// Whether q > (n^(1/4) + 1)^2, the bound above the group order of any curve
+// over F_p for p <= sqrt(n). Tested as (floor(sqrt(q)) - 1)^4 > n, which is
+// never true when the bound fails and false only right at the edge.
+bool exceeds_hasse_bound(const mpz_class& q, const mpz_class& n);
+
+#endif
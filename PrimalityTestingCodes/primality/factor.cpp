@@ -0,0 +1,430 @@
+#include "primality/factor.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "primality/fixed_width.h"
+#include "primality/montgomery.h"
+#include "primality/perfect_power.h"
+#include "primality/primality.h"
+#include "primality/trial_division.h"
+
+namespace {
+
+// Steps between gcds in rho, and between deadline checks elsewhere
+constexpr uint64_t rho_batch = 128;
+constexpr size_t primes_per_check = 64;
+
+bool past(FactorDeadline deadline) {
+    return deadline != no_factor_deadline && std::chrono::steady_clock::now() >= deadline;
+}
+
+// Primes up to bound, by a plain sieve; the bounds used here are small
+std::vector<unsigned long> primes_up_to(unsigned long bound) {
+    std::vector<bool> composite(bound + 1, false);
+    std::vector<unsigned long> primes;
+    for (unsigned long p = 2; p <= bound; ++p) {
+        if (composite[p])
+            continue;
+        primes.push_back(p);
+        for (unsigned long m = p * p; m <= bound; m += p)
+            composite[m] = true;
+    }
+    return primes;
+}
+
+// Largest power of p that is at most bound
+unsigned long prime_power(unsigned long p, unsigned long bound) {
+    unsigned long q = p;
+    while (q <= bound / p)
+        q *= p;
+    return q;
+}
+
+template <typename Word>
+Word binary_gcd(Word a, Word b) {
+    if (a == 0)
+        return b;
+    if (b == 0)
+        return a;
+    int shift = 0;
+    while (((a | b) & 1) == 0) {
+        a >>= 1;
+        b >>= 1;
+        ++shift;
+    }
+    while ((a & 1) == 0)
+        a >>= 1;
+    while (b != 0) {
+        while ((b & 1) == 0)
+            b >>= 1;
+        if (a > b)
+            std::swap(a, b);
+        b -= a;
+    }
+    return a << shift;
+}
+
+// Brent's rho on x^2 + c for an n that fits in one Word, in Montgomery form
+// (the map is still a pseudo-random polynomial map and gcds are unchanged by
+// the factor R). Returns a nontrivial factor, or 0; `iterations` is charged
+// with the steps.
+template <typename Word>
+Word rho_native(Word n, Word c, uint64_t max_iterations, uint64_t& iterations, FactorDeadline deadline) {
+    FixedMontgomery<Word> mont(n);
+    auto step = [&](Word y) { return mont.add(mont.mul(y, y), c); };
+
+    Word x = 0, y = mont.to_montgomery(2), ys = y, q = mont.one(), g = 1;
+    for (uint64_t r = 1; g == 1; r *= 2) {
+        x = y;
+        for (uint64_t i = 0; i < r; ++i)
+            y = step(y);
+        for (uint64_t k = 0; k < r && g == 1; k += rho_batch) {
+            ys = y;
+            uint64_t steps = std::min(rho_batch, r - k);
+            for (uint64_t i = 0; i < steps; ++i) {
+                y = step(y);
+                q = mont.mul(q, x > y ? x - y : y - x);
+            }
+            g = binary_gcd(q, n);
+            iterations += steps;
+            if (g == 1 && (iterations >= max_iterations || past(deadline)))
+                return 0;
+        }
+    }
+    if (g == n) {
+        // The batch overshot; redo it one step at a time
+        do {
+            ys = step(ys);
+            g = binary_gcd(x > ys ? x - ys : ys - x, n);
+        } while (g == 1);
+    }
+    return g == n ? 0 : g;
+}
+
+// gcd(a, n) for a residue in Montgomery form; R is prime to n, so the factor
+// it carries does not change the gcd
+void residue_gcd(mpz_class& g, const mp_limb_t* a, mp_size_t size, const mpz_class& n) {
+    mpz_t view;
+    mpz_gcd(g.get_mpz_t(), mpz_roinit_n(view, a, size), n.get_mpz_t());
+}
+
+// rho_native on the mpn Montgomery kernel, for n above 128 bits
+bool rho_mpz(mpz_class& factor, const mpz_class& n, unsigned long c, uint64_t max_iterations, uint64_t& iterations,
+             FactorDeadline deadline) {
+    MontgomeryContext mont(n.get_mpz_t());
+    mp_size_t size = mont.size();
+    std::vector<mp_limb_t> limbs(6 * size);
+    mp_limb_t *x = &limbs[0], *y = &limbs[size], *ys = &limbs[2 * size], *q = &limbs[3 * size],
+              *diff = &limbs[4 * size], *constant = &limbs[5 * size];
+    mont.to_montgomery(constant, mpz_class(c).get_mpz_t());
+    mont.to_montgomery(y, mpz_class(2).get_mpz_t());
+    std::copy(mont.one(), mont.one() + size, q);
+    auto step = [&](mp_limb_t* v) {
+        mont.sqr(v, v);
+        mont.add(v, v, constant);
+    };
+
+    mpz_class g = 1;
+    for (uint64_t r = 1; g == 1; r *= 2) {
+        std::copy(y, y + size, x);
+        for (uint64_t i = 0; i < r; ++i)
+            step(y);
+        for (uint64_t k = 0; k < r && g == 1; k += rho_batch) {
+            std::copy(y, y + size, ys);
+            uint64_t steps = std::min(rho_batch, r - k);
+            for (uint64_t i = 0; i < steps; ++i) {
+                step(y);
+                mont.sub(diff, x, y);
+                mont.mul(q, q, diff);
+            }
+            residue_gcd(g, q, size, n);
+            iterations += steps;
+            if (g == 1 && (iterations >= max_iterations || past(deadline)))
+                return false;
+        }
+    }
+    if (g == n) {
+        do {
+            step(ys);
+            mont.sub(diff, x, ys);
+            residue_gcd(g, diff, size, n);
+        } while (g == 1);
+    }
+    if (g == n)
+        return false;
+    factor = g;
+    return true;
+}
+
+// Stage 1 arithmetic on a Montgomery curve By^2 = x^3 + Ax^2 + x mod n, in
+// projective x-only coordinates (X : Z) with every residue in Montgomery form
+class MontgomeryCurve {
+public:
+    explicit MontgomeryCurve(const mpz_class& n) : n_(n), mont_(n.get_mpz_t()), size_(mont_.size()) {
+        limbs_.resize(10 * size_);
+        mp_limb_t* next = limbs_.data();
+        for (mp_limb_t** r : {&x_, &z_, &a24_, &x1_, &z1_, &x2_, &z2_, &s_, &d_, &t_}) {
+            *r = next;
+            next += size_;
+        }
+    }
+
+    // Suyama's curve for sigma with its point (u^3 : v^3), where a24 = (A + 2) / 4.
+    // False with factor set if the inversion exposed one, or factor = 0 if
+    // the curve is unusable.
+    bool init(unsigned long sigma, mpz_class& factor) {
+        mpz_class u = mpz_class(sigma) * sigma - 5, v = mpz_class(4) * sigma;
+        mpz_class u3 = u * u * u, diff = v - u;
+        mpz_class numerator = diff * diff * diff * (3 * u + v);
+        mpz_class denominator = 16 * u3 * v;
+        if (!mpz_invert(denominator.get_mpz_t(), denominator.get_mpz_t(), n_.get_mpz_t())) {
+            mpz_gcd(factor.get_mpz_t(), denominator.get_mpz_t(), n_.get_mpz_t());
+            if (factor == n_)
+                factor = 0;
+            return false;
+        }
+        mpz_class a24 = numerator * denominator % n_, x = u3 % n_, z = v * v * v % n_;
+        mont_.to_montgomery(a24_, a24.get_mpz_t());
+        mont_.to_montgomery(x_, x.get_mpz_t());
+        mont_.to_montgomery(z_, z.get_mpz_t());
+        return true;
+    }
+
+    // Current point <- k * current point, by the Montgomery ladder
+    void multiply(unsigned long k) {
+        if (k < 2)
+            return;
+        copy(x1_, x_);
+        copy(z1_, z_);
+        copy(x2_, x_);
+        copy(z2_, z_);
+        dbl(x2_, z2_);
+        for (int i = 62 - __builtin_clzl(k); i >= 0; --i) {
+            if ((k >> i) & 1) {
+                add(x1_, z1_, x2_, z2_);
+                dbl(x2_, z2_);
+            } else {
+                add(x2_, z2_, x1_, z1_);
+                dbl(x1_, z1_);
+            }
+        }
+        copy(x_, x1_);
+        copy(z_, z1_);
+    }
+
+    // gcd(Z, n), which exposes p once the point is the identity mod p
+    void z_gcd(mpz_class& g) const { residue_gcd(g, z_, size_, n_); }
+
+private:
+    void copy(mp_limb_t* r, const mp_limb_t* a) const { std::copy(a, a + size_, r); }
+
+    // (X : Z) <- 2 (X : Z)
+    void dbl(mp_limb_t* x, mp_limb_t* z) {
+        mont_.add(s_, x, z);
+        mont_.sqr(s_, s_);
+        mont_.sub(d_, x, z);
+        mont_.sqr(d_, d_);
+        mont_.mul(x, s_, d_);
+        mont_.sub(t_, s_, d_);
+        mont_.mul(z, a24_, t_);
+        mont_.add(z, z, d_);
+        mont_.mul(z, z, t_);
+    }
+
+    // (X : Z) <- (X : Z) + (X' : Z'), whose difference is the point being multiplied
+    void add(mp_limb_t* x, mp_limb_t* z, const mp_limb_t* xp, const mp_limb_t* zp) {
+        mont_.sub(s_, x, z);
+        mont_.add(t_, xp, zp);
+        mont_.mul(s_, s_, t_);
+        mont_.add(d_, x, z);
+        mont_.sub(t_, xp, zp);
+        mont_.mul(d_, d_, t_);
+        mont_.add(t_, s_, d_);
+        mont_.sqr(t_, t_);
+        mont_.sub(s_, s_, d_);
+        mont_.sqr(s_, s_);
+        mont_.mul(x, z_, t_);
+        mont_.mul(z, x_, s_);
+    }
+
+    const mpz_class& n_;
+    MontgomeryContext mont_;
+    mp_size_t size_;
+    std::vector<mp_limb_t> limbs_;
+    mp_limb_t *x_, *z_, *a24_;      // the point being multiplied and the curve
+    mp_limb_t *x1_, *z1_, *x2_, *z2_;  // ladder state
+    mp_limb_t *s_, *d_, *t_;        // scratch
+};
+
+// One nontrivial factor of the odd composite n, which is not a perfect power
+bool find_factor(mpz_class& factor, const mpz_class& n, const FactorizationOptions& options,
+                 FactorDeadline deadline) {
+    if (pollard_rho(factor, n, options.rho_iterations, deadline))
+        return true;
+    if (!past(deadline) && pollard_pm1(factor, n, options.pm1_bound, deadline))
+        return true;
+    return !past(deadline) && ecm(factor, n, options.ecm_bound, options.ecm_curves, deadline);
+}
+
+void merge(std::vector<std::pair<mpz_class, unsigned long>>& factors) {
+    std::sort(factors.begin(), factors.end());
+    size_t kept = 0;
+    for (size_t i = 0; i < factors.size(); ++i) {
+        if (kept > 0 && factors[kept - 1].first == factors[i].first)
+            factors[kept - 1].second += factors[i].second;
+        else
+            factors[kept++] = factors[i];
+    }
+    factors.resize(kept);
+}
+
+}  // namespace
+
+bool pollard_rho(mpz_class& factor, const mpz_class& n, uint64_t max_iterations, FactorDeadline deadline) {
+    uint64_t iterations = 0;
+    size_t bits = mpz_sizeinbase(n.get_mpz_t(), 2);
+    for (unsigned long c = 1; iterations < max_iterations && !past(deadline); ++c) {
+        uint128_t found = 0;
+        if (bits <= 64) {
+            uint64_t small = mpz_get_ui(n.get_mpz_t());
+            found = rho_native<uint64_t>(small, c, max_iterations, iterations, deadline);
+        } else if (bits <= 128) {
+            found = rho_native<uint128_t>(mpz_get_u128(n.get_mpz_t()), c, max_iterations, iterations, deadline);
+        } else if (rho_mpz(factor, n, c, max_iterations, iterations, deadline)) {
+            return true;
+        }
+        if (found != 0) {
+            mpz_import(factor.get_mpz_t(), 2, -1, sizeof(uint64_t), 0, 0, &found);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool pollard_pm1(mpz_class& factor, const mpz_class& n, unsigned long bound, FactorDeadline deadline) {
+    std::vector<unsigned long> primes = primes_up_to(bound);
+    mpz_class a = 2, saved, exponent, g;
+    for (size_t start = 0; start < primes.size(); start += primes_per_check) {
+        if (past(deadline))
+            return false;
+        size_t end = std::min(primes.size(), start + primes_per_check);
+
+        // One exponentiation by the product of a run of prime powers
+        saved = a;
+        exponent = 1;
+        for (size_t i = start; i < end; ++i)
+            exponent *= prime_power(primes[i], bound);
+        mpz_powm(a.get_mpz_t(), a.get_mpz_t(), exponent.get_mpz_t(), n.get_mpz_t());
+        g = a - 1;
+        mpz_gcd(g.get_mpz_t(), g.get_mpz_t(), n.get_mpz_t());
+        if (g == 1)
+            continue;
+        if (g == n) {
+            // Every factor's order divided the run at once; go back one prime at a time
+            a = saved;
+            for (size_t i = start; i < end && g != 1; ++i) {
+                mpz_powm_ui(a.get_mpz_t(), a.get_mpz_t(), prime_power(primes[i], bound), n.get_mpz_t());
+                g = a - 1;
+                mpz_gcd(g.get_mpz_t(), g.get_mpz_t(), n.get_mpz_t());
+                if (g != 1 && g != n)
+                    break;
+            }
+            if (g == 1 || g == n)
+                return false;
+        }
+        factor = g;
+        return true;
+    }
+    return false;
+}
+
+bool ecm(mpz_class& factor, const mpz_class& n, unsigned long bound, unsigned curves, FactorDeadline deadline) {
+    std::vector<unsigned long> primes = primes_up_to(bound);
+    MontgomeryCurve curve(n);
+    mpz_class g;
+    for (unsigned c = 0; c < curves; ++c) {
+        if (past(deadline))
+            return false;
+        if (!curve.init(6 + c, g)) {
+            if (g != 0) {
+                factor = g;
+                return true;
+            }
+            continue;
+        }
+        bool expired = false;
+        for (size_t i = 0; i < primes.size() && !expired; ++i) {
+            curve.multiply(prime_power(primes[i], bound));
+            expired = (i + 1) % primes_per_check == 0 && past(deadline);
+        }
+        curve.z_gcd(g);
+        if (g != 1 && g != n) {
+            factor = g;
+            return true;
+        }
+        if (expired)
+            return false;
+    }
+    return false;
+}
+
+Factorization factorize(const mpz_class& n, const FactorizationOptions& options) {
+    FactorDeadline deadline = no_factor_deadline;
+    if (options.time_budget > 0)
+        deadline = std::chrono::steady_clock::now() +
+                   std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                       std::chrono::duration<double>(options.time_budget));
+
+    Factorization result;
+    if (n < 2)
+        return result;
+
+    // Small factors first, since they are the common case and the cheapest
+    mpz_class m = n;
+    for (unsigned long p; m > 1 && (p = trial_factor(m.get_mpz_t(), options.trial_limit)) != 0;) {
+        unsigned long exponent = 0;
+        while (mpz_divisible_ui_p(m.get_mpz_t(), p)) {
+            mpz_divexact_ui(m.get_mpz_t(), m.get_mpz_t(), p);
+            ++exponent;
+        }
+        result.primes.emplace_back(p, exponent);
+    }
+
+    std::vector<std::pair<mpz_class, unsigned long>> pending;
+    if (m > 1)
+        pending.emplace_back(m, 1);
+    mpz_class root, factor;
+    while (!pending.empty()) {
+        auto [part, exponent] = std::move(pending.back());
+        pending.pop_back();
+
+        if (is_bpsw_prime(part.get_mpz_t())) {
+            result.primes.emplace_back(std::move(part), exponent);
+            continue;
+        }
+        if (unsigned long power = perfect_power_exponent(part, &root)) {
+            pending.emplace_back(root, exponent * power);
+            continue;
+        }
+        if (past(deadline) || !find_factor(factor, part, options, deadline)) {
+            result.timed_out |= past(deadline);
+            result.composites.emplace_back(std::move(part), exponent);
+            continue;
+        }
+        pending.emplace_back(part / factor, exponent);
+        pending.emplace_back(factor, exponent);
+    }
+
+    merge(result.primes);
+    merge(result.composites);
+    return result;
+}
+
+bool is_probable_prime_or_factor(const mpz_t n, Factorization& factors, const FactorizationOptions& options, int k) {
+    factors = Factorization();
+    if (is_probable_prime(n, k))
+        return true;
+    factors = factorize(mpz_class(n), options);
+    return false;
+}
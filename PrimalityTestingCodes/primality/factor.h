@@ -0,0 +1,65 @@
+#ifndef PRIMALITY_FACTOR_H
+#define PRIMALITY_FACTOR_H
+
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <gmp.h>
+#include <gmpxx.h>
+
+// Factor extraction for numbers the testers report composite. Every stage
+// watches a deadline and gives up when it passes, so factorize() returns a
+// partial factorization rather than running unbounded.
+
+using FactorDeadline = std::chrono::steady_clock::time_point;
+constexpr FactorDeadline no_factor_deadline = FactorDeadline::max();
+
+struct FactorizationOptions {
+    double time_budget = 1.0;                  // seconds for the whole call; <= 0 means no limit
+    unsigned long trial_limit = 1ul << 16;     // trial division bound
+    uint64_t rho_iterations = uint64_t(1) << 20;  // per composite
+    unsigned long pm1_bound = 100000;          // P-1 stage 1 bound B1
+    unsigned long ecm_bound = 11000;           // ECM stage 1 bound B1, for factors up to about 20 digits
+    unsigned ecm_curves = 200;                 // per composite
+};
+
+struct Factorization {
+    // Factors that pass BPSW, increasing, with their exponents
+    std::vector<std::pair<mpz_class, unsigned long>> primes;
+    // Parts no stage could split in time, with their exponents
+    std::vector<std::pair<mpz_class, unsigned long>> composites;
+    bool timed_out = false;
+
+    bool complete() const { return composites.empty(); }
+};
+
+// Trial division, then a perfect power check, then for each composite part
+// Brent's rho, P-1 and ECM in turn until one splits it
+Factorization factorize(const mpz_class& n, const FactorizationOptions& options = {});
+
+// is_probable_prime, and when n is composite, factorize(n, options) into
+// `factors` (left empty for a probable prime)
+bool is_probable_prime_or_factor(const mpz_t n, Factorization& factors, const FactorizationOptions& options = {},
+                                 int k = -1);
+
+// The stages on their own. Each stores a nontrivial factor of the composite
+// n (odd, not a perfect power) and returns true, or returns false once its
+// limit or the deadline is reached.
+
+// Brent's cycle finding on x^2 + c, with the differences multiplied together
+// and one gcd per 128 steps. An n that fits in 64 bits runs natively in
+// Montgomery form. Several c are tried within the iteration budget.
+bool pollard_rho(mpz_class& factor, const mpz_class& n, uint64_t max_iterations,
+                 FactorDeadline deadline = no_factor_deadline);
+
+// Stage 1 of P-1: finds p when p - 1 is bound-smooth
+bool pollard_pm1(mpz_class& factor, const mpz_class& n, unsigned long bound,
+                 FactorDeadline deadline = no_factor_deadline);
+
+// Stage 1 of ECM on Montgomery curves with Suyama's parametrization, using
+// the x-only ladder; finds p when a curve's group order mod p is bound-smooth
+bool ecm(mpz_class& factor, const mpz_class& n, unsigned long bound, unsigned curves,
+         FactorDeadline deadline = no_factor_deadline);
+
+#endif
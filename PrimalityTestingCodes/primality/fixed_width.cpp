@@ -0,0 +1,449 @@
+#include "primality/fixed_width.h"
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PRIMALITY_X86_SIMD 1
+#include <immintrin.h>
+#define PRIMALITY_TARGET_AVX2 __attribute__((target("avx2")))
+#define PRIMALITY_TARGET_IFMA __attribute__((target("avx512f,avx512ifma")))
+#endif
+
+namespace {
+
+const uint64_t small_primes[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41};
+// Sinclair's bases, exact for every 64-bit n
+const uint64_t u64_bases[] = {2, 325, 9375, 28178, 450775, 9780504, 1795265022};
+
+// Returns 1 or 0 when a small prime decides n, -1 otherwise
+template <typename Word>
+int small_prime_verdict(Word n) {
+    if (n < 2)
+        return 0;
+    for (uint64_t p : small_primes) {
+        if (n == p)
+            return 1;
+        if (n % p == 0)
+            return 0;
+    }
+    return n < 43 * 43 ? 1 : -1;
+}
+
+}  // namespace
+
+const uint128_t deterministic_u128_bound = (static_cast<uint128_t>(179817) << 64) | 5885577656943027709ull;
+
+bool is_prime_u64(uint64_t n, int* rounds_run) {
+    if (rounds_run)
+        *rounds_run = 0;
+    int verdict = small_prime_verdict(n);
+    if (verdict >= 0)
+        return verdict;
+
+    FixedMontgomery<uint64_t> mont(n);
+    for (uint64_t a : u64_bases) {
+        if (rounds_run)
+            ++*rounds_run;
+        if (!strong_probable_prime(mont, a))
+            return false;
+    }
+    return true;
+}
+
+bool is_prime_u128_below_bound(uint128_t n, int* rounds_run) {
+    if (n >> 64 == 0)
+        return is_prime_u64(static_cast<uint64_t>(n), rounds_run);
+
+    if (rounds_run)
+        *rounds_run = 0;
+    int verdict = small_prime_verdict(n);
+    if (verdict >= 0)
+        return verdict;
+
+    FixedMontgomery<uint128_t> mont(n);
+    for (uint64_t a : small_primes) {
+        if (rounds_run)
+            ++*rounds_run;
+        if (!strong_probable_prime<uint128_t>(mont, a))
+            return false;
+    }
+    return true;
+}
+
+namespace {
+
+// Each kernel call covers this many vectors of lanes; a single vector is one
+// dependent chain of products and leaves the multipliers mostly idle
+constexpr int simd_groups = 4;
+constexpr size_t max_block_lanes = 8 * simd_groups;
+
+// Everything a kernel needs for one base over one block of lanes; unused
+// lanes repeat the first number
+struct LaneBlock {
+    alignas(64) uint64_t n[max_block_lanes], ninv[max_block_lanes], one[max_block_lanes],
+        minus_one[max_block_lanes], base[max_block_lanes], d[max_block_lanes], s[max_block_lanes];
+    unsigned bits;    // longest d
+    unsigned max_s;
+    bool always_pass[max_block_lanes];  // base is a multiple of n, which says nothing
+};
+
+// -n^-1 mod 2^64 for odd n
+uint64_t negated_inverse(uint64_t n) {
+    uint64_t inverse = n;  // n * n = 1 mod 8
+    for (int correct = 3; correct < 64; correct *= 2)
+        inverse *= 2 - n * inverse;
+    return -inverse;
+}
+
+// A number still undecided, with the constants every base reuses
+struct PendingNumber {
+    size_t index;
+    uint64_t n, ninv, one, d;  // one = R mod n
+    unsigned s;
+};
+
+// R = 2^r_bits, 64 or 104
+PendingNumber pending_number(size_t index, uint64_t n, int r_bits) {
+    unsigned s = __builtin_ctzll(n - 1);
+    uint64_t one = r_bits == 64 ? uint64_t(-n) % n : static_cast<uint64_t>((uint128_t(1) << r_bits) % n);
+    return {index, n, negated_inverse(n), one, (n - 1) >> s, s};
+}
+
+void fill_block(LaneBlock& block, const PendingNumber* numbers, size_t used, size_t lanes, uint64_t a) {
+    uint64_t longest = 0;
+    block.max_s = 0;
+    for (size_t l = 0; l < lanes; ++l) {
+        const PendingNumber& number = numbers[l < used ? l : 0];
+        uint64_t n = number.n;
+        block.n[l] = n;
+        block.ninv[l] = number.ninv;
+        block.one[l] = number.one;
+        block.minus_one[l] = n - number.one;
+        block.base[l] = a == 2 ? 0 : static_cast<uint64_t>(uint128_t(a % n) * number.one % n);
+        block.d[l] = number.d;
+        block.s[l] = number.s;
+        block.always_pass[l] = a % n == 0;
+        longest = std::max(longest, number.d);
+        block.max_s = std::max(block.max_s, number.s);
+    }
+    block.bits = 64 - __builtin_clzll(longest);
+}
+
+#ifdef PRIMALITY_X86_SIMD
+
+// Montgomery product over 32-bit digits, two per 64-bit lane; ninv only
+// needs its low 32 bits
+PRIMALITY_TARGET_AVX2 inline __m256i avx2_mul(__m256i a, __m256i b, __m256i n, __m256i ninv) {
+    const __m256i low = _mm256_set1_epi64x(0xffffffff);
+    const __m256i sign = _mm256_set1_epi64x(static_cast<long long>(1ull << 63));
+    __m256i a1 = _mm256_srli_epi64(a, 32), b1 = _mm256_srli_epi64(b, 32), n1 = _mm256_srli_epi64(n, 32);
+
+    // Digit 0 of a, then m * n clears the low digit
+    __m256i p0 = _mm256_mul_epu32(a, b), p1 = _mm256_mul_epu32(a, b1);
+    __m256i t0 = _mm256_and_si256(p0, low);
+    __m256i t1 = _mm256_add_epi64(_mm256_srli_epi64(p0, 32), _mm256_and_si256(p1, low));
+    __m256i t2 = _mm256_srli_epi64(p1, 32);
+    __m256i m = _mm256_mul_epu32(t0, ninv);
+    __m256i q0 = _mm256_mul_epu32(m, n), q1 = _mm256_mul_epu32(m, n1);
+    t0 = _mm256_add_epi64(t0, _mm256_and_si256(q0, low));
+    t1 = _mm256_add_epi64(t1, _mm256_add_epi64(_mm256_srli_epi64(q0, 32),
+                                                _mm256_add_epi64(_mm256_and_si256(q1, low), _mm256_srli_epi64(t0, 32))));
+    t2 = _mm256_add_epi64(t2, _mm256_srli_epi64(q1, 32));
+
+    // Digit 1 of a on the shifted accumulator
+    p0 = _mm256_mul_epu32(a1, b);
+    p1 = _mm256_mul_epu32(a1, b1);
+    t0 = _mm256_add_epi64(t1, _mm256_and_si256(p0, low));
+    t1 = _mm256_add_epi64(t2, _mm256_add_epi64(_mm256_srli_epi64(p0, 32), _mm256_and_si256(p1, low)));
+    t2 = _mm256_srli_epi64(p1, 32);
+    m = _mm256_mul_epu32(t0, ninv);
+    q0 = _mm256_mul_epu32(m, n);
+    q1 = _mm256_mul_epu32(m, n1);
+    t0 = _mm256_add_epi64(t0, _mm256_and_si256(q0, low));
+    t1 = _mm256_add_epi64(t1, _mm256_add_epi64(_mm256_srli_epi64(q0, 32),
+                                                _mm256_add_epi64(_mm256_and_si256(q1, low), _mm256_srli_epi64(t0, 32))));
+    t2 = _mm256_add_epi64(t2, _mm256_srli_epi64(q1, 32));
+
+    // r = t2 * 2^32 + t1 < 2n, which may carry out of 64 bits
+    t2 = _mm256_add_epi64(t2, _mm256_srli_epi64(t1, 32));
+    __m256i r = _mm256_or_si256(_mm256_and_si256(t1, low), _mm256_slli_epi64(t2, 32));
+    __m256i carry = _mm256_cmpeq_epi64(_mm256_srli_epi64(t2, 32), _mm256_setzero_si256());
+    __m256i below = _mm256_cmpgt_epi64(_mm256_xor_si256(n, sign), _mm256_xor_si256(r, sign));
+    // Subtract n unless there was no carry and r < n
+    __m256i keep = _mm256_and_si256(carry, below);
+    return _mm256_blendv_epi8(_mm256_sub_epi64(r, n), r, keep);
+}
+
+// 2x mod n for x in [0, n)
+PRIMALITY_TARGET_AVX2 inline __m256i avx2_double(__m256i x, __m256i n) {
+    const __m256i sign = _mm256_set1_epi64x(static_cast<long long>(1ull << 63));
+    __m256i r = _mm256_add_epi64(x, x);
+    __m256i carry = _mm256_cmpeq_epi64(_mm256_srli_epi64(x, 63), _mm256_setzero_si256());
+    __m256i below = _mm256_cmpgt_epi64(_mm256_xor_si256(n, sign), _mm256_xor_si256(r, sign));
+    return _mm256_blendv_epi8(_mm256_sub_epi64(r, n), r, _mm256_and_si256(carry, below));
+}
+
+// One strong probable prime round per lane; bit l of the result is lane l's pass
+PRIMALITY_TARGET_AVX2 uint32_t avx2_round(const LaneBlock& block, bool base_two) {
+    const int G = simd_groups;
+    __m256i n[G], ninv[G], one[G], minus_one[G], base[G], d[G], s[G], x[G];
+    for (int g = 0; g < G; ++g) {
+        n[g] = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.n + 4 * g));
+        ninv[g] = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.ninv + 4 * g));
+        one[g] = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.one + 4 * g));
+        minus_one[g] = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.minus_one + 4 * g));
+        base[g] = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.base + 4 * g));
+        d[g] = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.d + 4 * g));
+        s[g] = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.s + 4 * g));
+        x[g] = one[g];
+    }
+
+    // Left to right over the longest d; shorter exponents square one meanwhile.
+    // Base 2 doubles on a set bit, other bases take 2-bit windows from a, a^2, a^3.
+    if (base_two) {
+        for (int j = static_cast<int>(block.bits) - 1; j >= 0; --j) {
+            const __m256i mask = _mm256_set1_epi64x(1ll << j);
+            for (int g = 0; g < G; ++g) {
+                x[g] = avx2_mul(x[g], x[g], n[g], ninv[g]);
+                __m256i clear = _mm256_cmpeq_epi64(_mm256_and_si256(d[g], mask), _mm256_setzero_si256());
+                x[g] = _mm256_blendv_epi8(avx2_double(x[g], n[g]), x[g], clear);
+            }
+        }
+    } else {
+        __m256i square[G], cube[G];
+        for (int g = 0; g < G; ++g) {
+            square[g] = avx2_mul(base[g], base[g], n[g], ninv[g]);
+            cube[g] = avx2_mul(square[g], base[g], n[g], ninv[g]);
+        }
+        const __m256i three = _mm256_set1_epi64x(3), two = _mm256_set1_epi64x(2);
+        for (int j = static_cast<int>((block.bits + 1) & ~1u) - 2; j >= 0; j -= 2) {
+            const __m128i shift = _mm_cvtsi32_si128(j);
+            for (int g = 0; g < G; ++g) {
+                x[g] = avx2_mul(x[g], x[g], n[g], ninv[g]);
+                x[g] = avx2_mul(x[g], x[g], n[g], ninv[g]);
+                __m256i window = _mm256_and_si256(_mm256_srl_epi64(d[g], shift), three);
+                __m256i y = _mm256_blendv_epi8(base[g], square[g], _mm256_cmpeq_epi64(window, two));
+                y = _mm256_blendv_epi8(y, cube[g], _mm256_cmpeq_epi64(window, three));
+                __m256i clear = _mm256_cmpeq_epi64(window, _mm256_setzero_si256());
+                x[g] = _mm256_blendv_epi8(avx2_mul(x[g], y, n[g], ninv[g]), x[g], clear);
+            }
+        }
+    }
+
+    __m256i passed[G], done[G];
+    for (int g = 0; g < G; ++g) {
+        passed[g] = _mm256_or_si256(_mm256_cmpeq_epi64(x[g], one[g]), _mm256_cmpeq_epi64(x[g], minus_one[g]));
+        done[g] = passed[g];
+    }
+    for (unsigned r = 1; r < block.max_s; ++r) {
+        __m256i any = _mm256_setzero_si256();
+        for (int g = 0; g < G; ++g) {
+            __m256i live = _mm256_andnot_si256(done[g], _mm256_cmpgt_epi64(s[g], _mm256_set1_epi64x(r)));
+            any = _mm256_or_si256(any, live);
+            x[g] = avx2_mul(x[g], x[g], n[g], ninv[g]);
+            __m256i at_minus_one = _mm256_and_si256(live, _mm256_cmpeq_epi64(x[g], minus_one[g]));
+            __m256i at_one = _mm256_and_si256(live, _mm256_cmpeq_epi64(x[g], one[g]));
+            passed[g] = _mm256_or_si256(passed[g], at_minus_one);
+            done[g] = _mm256_or_si256(done[g], _mm256_or_si256(at_minus_one, at_one));
+        }
+        if (_mm256_testz_si256(any, any))
+            break;
+    }
+
+    uint32_t bits = 0;
+    for (int g = 0; g < G; ++g)
+        bits |= static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(passed[g]))) << (4 * g);
+    return bits;
+}
+
+// x >> 52 in every lane. Shifts in the IFMA code use the zero-masked forms:
+// GCC 12's unmasked ones start from _mm512_undefined_epi32 and trip -Wuninitialized.
+PRIMALITY_TARGET_IFMA inline __m512i ifma_high(__m512i x) {
+    return _mm512_maskz_srli_epi64(0xFF, x, 52);
+}
+
+// Montgomery product over 52-bit digits, R = 2^104. The IFMA instructions
+// read only the low 52 bits of their factors, so a, b and n serve as their
+// own low digits.
+PRIMALITY_TARGET_IFMA inline __m512i ifma_mul(__m512i a, __m512i b, __m512i b1, __m512i n, __m512i n1,
+                                              __m512i ninv) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i low = _mm512_set1_epi64(0xfffffffffffffll);
+    __m512i a1 = ifma_high(a);
+
+    // Digit 0 of a, then m * n clears the low digit
+    __m512i t0 = _mm512_madd52lo_epu64(zero, a, b);
+    __m512i t1 = _mm512_madd52lo_epu64(_mm512_madd52hi_epu64(zero, a, b), a, b1);
+    __m512i t2 = _mm512_madd52hi_epu64(zero, a, b1);
+    __m512i m = _mm512_madd52lo_epu64(zero, t0, ninv);
+    t0 = _mm512_madd52lo_epu64(t0, m, n);
+    t1 = _mm512_madd52lo_epu64(_mm512_madd52hi_epu64(t1, m, n), m, n1);
+    t2 = _mm512_madd52hi_epu64(t2, m, n1);
+    t1 = _mm512_add_epi64(t1, ifma_high(t0));
+
+    // Digit 1 of a (below 2^12, so a1 * b1 has no high part) on the shifted accumulator
+    t0 = _mm512_madd52lo_epu64(t1, a1, b);
+    t1 = _mm512_madd52lo_epu64(_mm512_madd52hi_epu64(t2, a1, b), a1, b1);
+    m = _mm512_madd52lo_epu64(zero, t0, ninv);
+    t0 = _mm512_madd52lo_epu64(t0, m, n);
+    t1 = _mm512_madd52lo_epu64(_mm512_madd52hi_epu64(t1, m, n), m, n1);
+    t2 = _mm512_madd52hi_epu64(zero, m, n1);
+    t1 = _mm512_add_epi64(t1, ifma_high(t0));
+
+    // r = t2 * 2^52 + t1 < 2n, which may carry out of 64 bits
+    t2 = _mm512_add_epi64(t2, ifma_high(t1));
+    __m512i r = _mm512_or_si512(_mm512_and_si512(t1, low), _mm512_maskz_slli_epi64(0xFF, t2, 52));
+    __mmask8 reduce = _mm512_test_epi64_mask(t2, _mm512_set1_epi64(~0xfffll)) | _mm512_cmpge_epu64_mask(r, n);
+    return _mm512_mask_sub_epi64(r, reduce, r, n);
+}
+
+PRIMALITY_TARGET_IFMA inline __m512i ifma_double(__m512i x, __m512i n) {
+    __m512i r = _mm512_add_epi64(x, x);
+    __mmask8 reduce = _mm512_test_epi64_mask(x, _mm512_set1_epi64(static_cast<long long>(1ull << 63))) |
+                      _mm512_cmpge_epu64_mask(r, n);
+    return _mm512_mask_sub_epi64(r, reduce, r, n);
+}
+
+PRIMALITY_TARGET_IFMA uint32_t ifma_round(const LaneBlock& block, bool base_two) {
+    const int G = simd_groups;
+    __m512i n[G], n1[G], ninv[G], one[G], minus_one[G], base[G], base1[G], d[G], s[G], x[G];
+    for (int g = 0; g < G; ++g) {
+        n[g] = _mm512_load_si512(block.n + 8 * g);
+        n1[g] = ifma_high(n[g]);
+        ninv[g] = _mm512_load_si512(block.ninv + 8 * g);
+        one[g] = _mm512_load_si512(block.one + 8 * g);
+        minus_one[g] = _mm512_load_si512(block.minus_one + 8 * g);
+        base[g] = _mm512_load_si512(block.base + 8 * g);
+        base1[g] = ifma_high(base[g]);
+        d[g] = _mm512_load_si512(block.d + 8 * g);
+        s[g] = _mm512_load_si512(block.s + 8 * g);
+        x[g] = one[g];
+    }
+
+    // As in avx2_round
+    if (base_two) {
+        for (int j = static_cast<int>(block.bits) - 1; j >= 0; --j) {
+            const __m512i mask = _mm512_set1_epi64(1ll << j);
+            for (int g = 0; g < G; ++g) {
+                x[g] = ifma_mul(x[g], x[g], ifma_high(x[g]), n[g], n1[g], ninv[g]);
+                __mmask8 bit = _mm512_test_epi64_mask(d[g], mask);
+                x[g] = _mm512_mask_mov_epi64(x[g], bit, ifma_double(x[g], n[g]));
+            }
+        }
+    } else {
+        __m512i square[G], cube[G];
+        for (int g = 0; g < G; ++g) {
+            square[g] = ifma_mul(base[g], base[g], base1[g], n[g], n1[g], ninv[g]);
+            cube[g] = ifma_mul(square[g], base[g], base1[g], n[g], n1[g], ninv[g]);
+        }
+        const __m512i three = _mm512_set1_epi64(3), two = _mm512_set1_epi64(2);
+        for (int j = static_cast<int>((block.bits + 1) & ~1u) - 2; j >= 0; j -= 2) {
+            const __m128i shift = _mm_cvtsi32_si128(j);
+            for (int g = 0; g < G; ++g) {
+                x[g] = ifma_mul(x[g], x[g], ifma_high(x[g]), n[g], n1[g], ninv[g]);
+                x[g] = ifma_mul(x[g], x[g], ifma_high(x[g]), n[g], n1[g], ninv[g]);
+                __m512i window = _mm512_and_si512(_mm512_maskz_srl_epi64(0xFF, d[g], shift), three);
+                __m512i y = _mm512_mask_mov_epi64(base[g], _mm512_cmpeq_epi64_mask(window, two), square[g]);
+                y = _mm512_mask_mov_epi64(y, _mm512_cmpeq_epi64_mask(window, three), cube[g]);
+                __mmask8 set = _mm512_test_epi64_mask(window, window);
+                x[g] = _mm512_mask_mov_epi64(
+                    x[g], set, ifma_mul(x[g], y, ifma_high(y), n[g], n1[g], ninv[g]));
+            }
+        }
+    }
+
+    __mmask8 passed[G], done[G];
+    for (int g = 0; g < G; ++g) {
+        passed[g] = _mm512_cmpeq_epi64_mask(x[g], one[g]) | _mm512_cmpeq_epi64_mask(x[g], minus_one[g]);
+        done[g] = passed[g];
+    }
+    for (unsigned r = 1; r < block.max_s; ++r) {
+        __mmask8 any = 0;
+        for (int g = 0; g < G; ++g) {
+            __mmask8 live = ~done[g] & _mm512_cmpgt_epu64_mask(s[g], _mm512_set1_epi64(r));
+            any |= live;
+            x[g] = ifma_mul(x[g], x[g], ifma_high(x[g]), n[g], n1[g], ninv[g]);
+            __mmask8 at_minus_one = live & _mm512_cmpeq_epi64_mask(x[g], minus_one[g]);
+            passed[g] |= at_minus_one;
+            done[g] |= at_minus_one | (live & _mm512_cmpeq_epi64_mask(x[g], one[g]));
+        }
+        if (any == 0)
+            break;
+    }
+
+    uint32_t bits = 0;
+    for (int g = 0; g < G; ++g)
+        bits |= static_cast<uint32_t>(passed[g]) << (8 * g);
+    return bits;
+}
+
+#endif
+
+}  // namespace
+
+bool u64_batch_kernel_supported(U64BatchKernel kernel) {
+    switch (kernel) {
+    case U64BatchKernel::Scalar:
+        return true;
+#ifdef PRIMALITY_X86_SIMD
+    case U64BatchKernel::Avx2:
+        return __builtin_cpu_supports("avx2");
+    case U64BatchKernel::Avx512Ifma:
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512ifma");
+#endif
+    default:
+        return false;
+    }
+}
+
+U64BatchKernel best_u64_batch_kernel() {
+    static const U64BatchKernel best = u64_batch_kernel_supported(U64BatchKernel::Avx512Ifma) ? U64BatchKernel::Avx512Ifma
+                                       : u64_batch_kernel_supported(U64BatchKernel::Avx2)     ? U64BatchKernel::Avx2
+                                                                                              : U64BatchKernel::Scalar;
+    return best;
+}
+
+void is_prime_u64_batch(std::span<const uint64_t> numbers, std::span<unsigned char> verdicts, U64BatchKernel kernel) {
+    size_t count = std::min(numbers.size(), verdicts.size());
+    if (!u64_batch_kernel_supported(kernel))
+        kernel = U64BatchKernel::Scalar;
+    if (kernel == U64BatchKernel::Scalar) {
+        for (size_t i = 0; i < count; ++i)
+            verdicts[i] = is_prime_u64(numbers[i]);
+        return;
+    }
+
+#ifdef PRIMALITY_X86_SIMD
+    const bool avx2 = kernel == U64BatchKernel::Avx2;
+    const size_t lanes = (avx2 ? 4 : 8) * simd_groups;
+    std::vector<PendingNumber> pending;
+    for (size_t i = 0; i < count; ++i) {
+        int verdict = small_prime_verdict(numbers[i]);
+        if (verdict >= 0)
+            verdicts[i] = verdict;
+        else
+            pending.push_back(pending_number(i, numbers[i], avx2 ? 64 : 104));
+    }
+
+    LaneBlock block;
+    for (uint64_t a : u64_bases) {
+        // Survivors of this base are compacted to the front for the next one
+        size_t kept = 0;
+        for (size_t start = 0; start < pending.size(); start += lanes) {
+            size_t used = std::min(lanes, pending.size() - start);
+            fill_block(block, &pending[start], used, lanes, a);
+            uint32_t passed = avx2 ? avx2_round(block, a == 2) : ifma_round(block, a == 2);
+            for (size_t l = 0; l < used; ++l) {
+                if ((passed >> l & 1) || block.always_pass[l])
+                    pending[kept++] = pending[start + l];
+                else
+                    verdicts[pending[start + l].index] = 0;
+            }
+        }
+        pending.resize(kept);
+    }
+    for (const auto& number : pending)
+        verdicts[number.index] = 1;
+#endif
+}
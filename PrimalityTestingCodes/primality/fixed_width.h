@@ -0,0 +1,162 @@
+#ifndef PRIMALITY_FIXED_WIDTH_H
+#define PRIMALITY_FIXED_WIDTH_H
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <gmp.h>
+
+typedef unsigned __int128 uint128_t;
+
+// Full product of two words as (hi, lo)
+inline void wide_mul(uint64_t a, uint64_t b, uint64_t& hi, uint64_t& lo) {
+    uint128_t product = static_cast<uint128_t>(a) * b;
+    hi = static_cast<uint64_t>(product >> 64);
+    lo = static_cast<uint64_t>(product);
+}
+
+inline void wide_mul(uint128_t a, uint128_t b, uint128_t& hi, uint128_t& lo) {
+    const uint128_t mask = ~uint64_t(0);
+    uint128_t ll = (a & mask) * (b & mask);
+    uint128_t lh = (a & mask) * (b >> 64);
+    uint128_t hl = (a >> 64) * (b & mask);
+    uint128_t hh = (a >> 64) * (b >> 64);
+
+    uint128_t middle = (ll >> 64) + (lh & mask) + (hl & mask);
+    lo = (middle << 64) | (ll & mask);
+    hi = hh + (lh >> 64) + (hl >> 64) + (middle >> 64);
+}
+
+// Montgomery arithmetic modulo an odd n that fits in one Word, with R = 2^bits(Word).
+// Residues are kept in [0, n).
+template <typename Word>
+class FixedMontgomery {
+public:
+    static constexpr int bits = std::numeric_limits<Word>::digits;
+
+    explicit FixedMontgomery(Word n) : n_(n) {
+        // Newton iteration for n^-1 mod R, each step doubles the correct low bits
+        Word inverse = n;  // n * n = 1 mod 8
+        for (int correct = 3; correct < bits; correct *= 2)
+            inverse *= Word(2) - n * inverse;
+        inverse_ = inverse;
+
+        one_ = Word(-n) % n;  // R mod n
+        minus_one_ = n - one_;
+        // R^2 mod n by doubling R mod n another bits times
+        r2_ = one_;
+        for (int i = 0; i < bits; ++i)
+            r2_ = add(r2_, r2_);
+    }
+
+    Word modulus() const { return n_; }
+    Word one() const { return one_; }
+    Word minus_one() const { return minus_one_; }
+
+    // (hi * R + lo) / R mod n for hi * R + lo < n * R
+    Word reduce(Word hi, Word lo) const {
+        Word m = lo * inverse_;
+        Word mn_hi, mn_lo;
+        wide_mul(m, n_, mn_hi, mn_lo);
+        // The low words cancel exactly, so only the high words are subtracted
+        Word r = hi - mn_hi;
+        return hi < mn_hi ? r + n_ : r;
+    }
+
+    Word mul(Word a, Word b) const {
+        Word hi, lo;
+        wide_mul(a, b, hi, lo);
+        return reduce(hi, lo);
+    }
+
+    Word add(Word a, Word b) const {
+        Word sum = a + b;
+        return (sum < a || sum >= n_) ? sum - n_ : sum;
+    }
+
+    Word to_montgomery(Word a) const { return mul(a % n_, r2_); }
+    Word from_montgomery(Word a) const { return reduce(0, a); }
+
+    // base^exp in Montgomery form, right-to-left binary
+    Word pow(Word base, Word exp) const {
+        Word result = one_;
+        while (exp != 0) {
+            if (exp & 1)
+                result = mul(result, base);
+            base = mul(base, base);
+            exp >>= 1;
+        }
+        return result;
+    }
+
+private:
+    Word n_, inverse_, one_, minus_one_, r2_;
+};
+
+// One strong probable prime round with base a; n odd and > 3.
+// A base that is a multiple of n says nothing and passes.
+template <typename Word>
+bool strong_probable_prime(const FixedMontgomery<Word>& mont, Word a) {
+    Word n = mont.modulus();
+    a %= n;
+    if (a == 0)
+        return true;
+
+    Word n_minus_1 = n - 1;
+    int s = 0;
+    while (((n_minus_1 >> s) & 1) == 0)
+        ++s;
+    Word d = n_minus_1 >> s;
+
+    Word x = mont.pow(mont.to_montgomery(a), d);
+    if (x == mont.one() || x == mont.minus_one())
+        return true;
+
+    for (int r = 1; r < s; ++r) {
+        x = mont.mul(x, x);
+        if (x == mont.minus_one())
+            return true;
+        if (x == mont.one())
+            return false;
+    }
+    return false;
+}
+
+// Deterministic for every 64-bit n, using the 7-base set found by Jim Sinclair.
+// If rounds_run is given it receives the number of bases that were tried.
+bool is_prime_u64(uint64_t n, int* rounds_run = nullptr);
+
+// Code path of is_prime_u64_batch
+enum class U64BatchKernel {
+    Scalar,      // is_prime_u64 on each number
+    Avx2,        // 4 lanes, 32 x 32-bit products, R = 2^64
+    Avx512Ifma   // 8 lanes, 52-bit IFMA products, R = 2^104
+};
+// Whether this CPU (and OS) can run the kernel, checked at run time
+bool u64_batch_kernel_supported(U64BatchKernel kernel);
+// Widest supported kernel
+U64BatchKernel best_u64_batch_kernel();
+
+// verdicts[i] = is_prime_u64(numbers[i]) for the first min(sizes) entries.
+// After trial division by the small primes, a SIMD kernel runs one base at a
+// time over every number still undecided, with independent numbers in its
+// lanes moving through the exponent bits in lockstep; a composite leaves
+// after the first base that exposes it. Base 2 doubles instead of
+// multiplying. An unsupported kernel falls back to Scalar.
+void is_prime_u64_batch(std::span<const uint64_t> numbers, std::span<unsigned char> verdicts,
+                        U64BatchKernel kernel = best_u64_batch_kernel());
+
+// Every 128-bit n below this bound (about 3.3e24) is decided exactly by the
+// first 13 prime bases 2..41 (Sorenson and Webster)
+extern const uint128_t deterministic_u128_bound;
+bool is_prime_u128_below_bound(uint128_t n, int* rounds_run = nullptr);
+
+// Low 128 bits of n
+inline uint128_t mpz_get_u128(const mpz_t n) {
+    uint128_t low = mpz_getlimbn(n, 0);
+    if (GMP_NUMB_BITS == 64 && mpz_size(n) > 1)
+        low |= static_cast<uint128_t>(mpz_getlimbn(n, 1)) << 64;
+    return low;
+}
+
+#endif
@@ -0,0 +1,98 @@
+#include "primality/lucas.h"
+
+#include <algorithm>
+
+LucasContext::LucasContext() : q_(0), q_sign_(1) {
+    mpz_inits(d_, scratch_, NULL);
+}
+
+LucasContext::~LucasContext() {
+    mpz_clears(d_, scratch_, NULL);
+}
+
+void LucasContext::small_to_montgomery(mp_limb_t* r, long c, const mpz_t n) {
+    mpz_set_si(scratch_, c);
+    mpz_mod(scratch_, scratch_, n);
+    montgomery_.to_montgomery(r, scratch_);
+}
+
+void LucasContext::double_v() {
+    montgomery_.sqr(v_.data(), v_.data());
+    if (q_ == -1) {
+        if (q_sign_ > 0)
+            montgomery_.sub(v_.data(), v_.data(), two_.data());
+        else
+            montgomery_.add(v_.data(), v_.data(), two_.data());
+        q_sign_ = 1;
+    } else {
+        montgomery_.add(t_.data(), qk_.data(), qk_.data());
+        montgomery_.sub(v_.data(), v_.data(), t_.data());
+        montgomery_.sqr(qk_.data(), qk_.data());
+    }
+}
+
+bool LucasContext::strong_probable_prime(const mpz_t n) {
+    // A square n makes every Jacobi symbol non-negative, so the search below
+    // would never end
+    if (mpz_perfect_square_p(n))
+        return false;
+
+    long D = 5;
+    for (;;) {
+        int jacobi = mpz_si_kronecker(D, n);
+        if (jacobi == -1)
+            break;
+        if (jacobi == 0)
+            return mpz_cmpabs_ui(n, static_cast<unsigned long>(D < 0 ? -D : D)) == 0;
+        D = D > 0 ? -(D + 2) : -D + 2;
+    }
+    q_ = (1 - D) / 4;
+
+    montgomery_.set_modulus(n);
+    size_t size = montgomery_.size();
+    for (auto* limbs : {&u_, &v_, &qk_, &t_, &d_mont_, &q_mont_, &two_})
+        limbs->resize(size);
+    small_to_montgomery(d_mont_.data(), D, n);
+    small_to_montgomery(q_mont_.data(), q_, n);
+    montgomery_.add(two_.data(), montgomery_.one(), montgomery_.one());
+
+    // n + 1 = 2^s * d with d odd
+    mpz_add_ui(d_, n, 1);
+    mp_bitcnt_t s = mpz_scan1(d_, 0);
+    mpz_tdiv_q_2exp(d_, d_, s);
+
+    // Left to right over the bits of d, starting from U_1 = 1, V_1 = P = 1
+    std::copy(montgomery_.one(), montgomery_.one() + size, u_.begin());
+    std::copy(montgomery_.one(), montgomery_.one() + size, v_.begin());
+    q_sign_ = -1;
+    qk_ = q_mont_;
+    for (long i = static_cast<long>(mpz_sizeinbase(d_, 2)) - 2; i >= 0; --i) {
+        // U_2k = U_k V_k, V_2k = V_k^2 - 2 Q^k
+        montgomery_.mul(u_.data(), u_.data(), v_.data());
+        double_v();
+
+        if (mpz_tstbit(d_, i)) {
+            // U_k+1 = (U_k + V_k) / 2, V_k+1 = (D U_k + V_k) / 2
+            montgomery_.mul(t_.data(), u_.data(), d_mont_.data());
+            montgomery_.add(t_.data(), t_.data(), v_.data());
+            montgomery_.add(u_.data(), u_.data(), v_.data());
+            montgomery_.half(u_.data(), u_.data());
+            montgomery_.half(v_.data(), t_.data());
+            if (q_ == -1)
+                q_sign_ = -q_sign_;
+            else
+                montgomery_.mul(qk_.data(), qk_.data(), q_mont_.data());
+        }
+    }
+
+    if (montgomery_.is_zero(u_.data()) || montgomery_.is_zero(v_.data()))
+        return true;
+
+    // V_2^r d = 0 for some 0 < r < s
+    for (mp_bitcnt_t r = 1; r < s; ++r) {
+        double_v();
+        if (montgomery_.is_zero(v_.data()))
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,38 @@
+#ifndef PRIMALITY_LUCAS_H
+#define PRIMALITY_LUCAS_H
+
+#include <vector>
+#include <gmp.h>
+
+#include "primality/montgomery.h"
+
+// Strong Lucas probable prime test with Selfridge's parameters (method A):
+// D is the first of 5, -7, 9, -11, ... with Jacobi (D/n) = -1, P = 1 and
+// Q = (1 - D) / 4. The Lucas chain runs in Montgomery form on the mpn layer,
+// and scratch is kept between calls like MillerRabinContext.
+class LucasContext {
+public:
+    LucasContext();
+    ~LucasContext();
+
+    LucasContext(const LucasContext&) = delete;
+    LucasContext& operator=(const LucasContext&) = delete;
+
+    // n must be odd and > 3. Perfect squares, which have no such D, and n
+    // sharing a factor with some D are reported composite.
+    bool strong_probable_prime(const mpz_t n);
+
+private:
+    // V_2k = V_k^2 - 2 Q^k, then Q^k becomes Q^2k
+    void double_v();
+    // Sets r to the Montgomery form of the small integer c
+    void small_to_montgomery(mp_limb_t* r, long c, const mpz_t n);
+
+    long q_;
+    int q_sign_;  // Q^k when Q = -1, which then needs no multiplications
+    MontgomeryContext montgomery_;
+    std::vector<mp_limb_t> u_, v_, qk_, t_, d_mont_, q_mont_, two_;
+    mpz_t d_, scratch_;
+};
+
+#endif
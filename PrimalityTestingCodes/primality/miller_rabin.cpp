@@ -0,0 +1,494 @@
+#include "primality/primality.h"
+#include "primality/fixed_width.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+int default_rounds(size_t num_digits, int factor) {
+    double loglog = std::log2(static_cast<double>(num_digits));
+    return std::max(5, factor * static_cast<int>(std::ceil(loglog)));
+}
+
+// Perform (base^exp) % mod using GMP
+void mod_exp(mpz_t result, const mpz_t base, const mpz_t exp, const mpz_t mod) {
+    mpz_powm(result, base, exp, mod);
+}
+
+bool miller_test(const mpz_t n, const mpz_t n_minus_1, const mpz_t d, mp_bitcnt_t s, const mpz_t a, mpz_t x) {
+    mod_exp(x, a, d, n);
+
+    if (mpz_cmp_ui(x, 1) == 0 || mpz_cmp(x, n_minus_1) == 0)
+        return true;
+
+    // Square x in place for the remaining s - 1 links of the chain
+    for (mp_bitcnt_t r = 1; r < s; ++r) {
+        mpz_mul(x, x, x);
+        mpz_mod(x, x, n);
+
+        if (mpz_cmp(x, n_minus_1) == 0)
+            return true;
+        if (mpz_cmp_ui(x, 1) == 0)
+            return false;
+    }
+
+    return false;
+}
+
+MillerRabinContext::MillerRabinContext() : MillerRabinContext(GMP_NUMB_BITS) {}
+
+MillerRabinContext::MillerRabinContext(mp_bitcnt_t bits)
+    : kernel_(MillerRabinKernel::Powm), fixed_width_(true), s_(0), reserved_bits_(0), count_allocations_(false), count_start_(0), last_allocations_(0) {
+    mpz_inits(n_, n_minus_1_, d_, a_, x_, NULL);
+    reserve(bits);
+}
+
+MillerRabinContext::~MillerRabinContext() {
+    set_count_allocations(false);
+    mpz_clears(n_, n_minus_1_, d_, a_, x_, NULL);
+}
+
+void MillerRabinContext::reserve(mp_bitcnt_t bits) {
+    if (bits <= reserved_bits_)
+        return;
+    // Round up to whole limbs so nearby sizes share one allocation
+    bits = (bits + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS * GMP_NUMB_BITS;
+
+    mpz_realloc2(n_, bits);
+    mpz_realloc2(n_minus_1_, bits);
+    mpz_realloc2(d_, bits);
+    mpz_realloc2(a_, bits);
+    // x holds the unreduced square between mpz_mul and mpz_mod
+    mpz_realloc2(x_, 2 * bits + GMP_NUMB_BITS);
+    reserved_bits_ = bits;
+}
+
+void MillerRabinContext::prepare(const mpz_t n) {
+    reserve(mpz_sizeinbase(n, 2));
+
+    mpz_set(n_, n);
+    mpz_sub_ui(n_minus_1_, n, 1);
+
+    // n - 1 = 2^s * d with d odd
+    s_ = mpz_scan1(n_minus_1_, 0);
+    mpz_tdiv_q_2exp(d_, n_minus_1_, s_);
+
+    if (kernel_ == MillerRabinKernel::Montgomery) {
+        montgomery_.set_modulus(n_);
+        base_.resize(montgomery_.size());
+        power_.resize(montgomery_.size());
+    }
+}
+
+bool MillerRabinContext::test(const mpz_t a) {
+    if (kernel_ == MillerRabinKernel::Powm)
+        return miller_test(n_, n_minus_1_, d_, s_, a, x_);
+
+    mp_limb_t* x = power_.data();
+    montgomery_.to_montgomery(base_.data(), a);
+    montgomery_.pow(x, base_.data(), d_);
+
+    if (montgomery_.equal(x, montgomery_.one()) || montgomery_.equal(x, montgomery_.minus_one()))
+        return true;
+
+    for (mp_bitcnt_t r = 1; r < s_; ++r) {
+        montgomery_.sqr(x, x);
+
+        if (montgomery_.equal(x, montgomery_.minus_one()))
+            return true;
+        if (montgomery_.equal(x, montgomery_.one()))
+            return false;
+    }
+
+    return false;
+}
+
+int MillerRabinContext::trivial_verdict(const mpz_t n) {
+    if (mpz_cmp_ui(n, 2) == 0 || mpz_cmp_ui(n, 3) == 0)
+        return 1;
+    if (mpz_cmp_ui(n, 1) <= 0 || mpz_even_p(n))
+        return 0;
+    return -1;
+}
+
+int MillerRabinContext::screen(const mpz_t n) {
+    int verdict = trivial_verdict(n);
+    if (verdict >= 0) {
+        record_prefilter_stage(verdict ? PrefilterStage::ProvenPrime : PrefilterStage::Trivial);
+        return verdict;
+    }
+    return prefilter_.screen(n);
+}
+
+bool MillerRabinContext::finish(bool result) {
+    record_prefilter_stage(result ? PrefilterStage::ProbablePrime : PrefilterStage::MillerRabin);
+    return result;
+}
+
+bool MillerRabinContext::is_probable_prime(const mpz_t n, int k, WitnessSource& source, int* rounds_run) {
+    if (k == -1)
+        k = default_rounds(mpz_sizeinbase(n, 10));
+    if (rounds_run)
+        *rounds_run = 0;
+
+    int verdict = screen(n);
+    if (verdict >= 0)
+        return verdict;
+    if (fixed_width_ && mpz_sizeinbase(n, 2) <= 128)
+        return finish(fixed_width_rounds(n, k, &source, rounds_run));
+
+    begin_count();
+    prepare(n);
+
+    bool result = true;
+    for (int i = 0; i < k && result; ++i) {
+        if (rounds_run)
+            ++*rounds_run;
+
+        source.next(a_, n_);
+
+        result = test(a_);
+    }
+
+    end_count();
+    return finish(result);
+}
+
+bool MillerRabinContext::is_probable_prime_parallel(const mpz_t n, int k, WitnessSource& source, ThreadPool& pool) {
+    if (k == -1)
+        k = default_rounds(mpz_sizeinbase(n, 10));
+    if (pool.size() < 2 || k < 2 || mpz_sizeinbase(n, 2) <= 128)
+        return is_probable_prime(n, k, source);
+
+    int verdict = screen(n);
+    if (verdict >= 0)
+        return verdict;
+
+    // Drawn here so the rounds see the bases the sequential loop would
+    witnesses_.resize(k);
+    for (auto& a : witnesses_)
+        source.next(a.get_mpz_t(), n);
+
+    std::atomic<bool> composite{false};
+    MillerRabinKernel kernel = kernel_;
+    std::vector<double> costs(k, 1.0);
+    // Each worker prepares its context for n once per run, on its first round.
+    // The caller's kernel is only lent to the worker for each round, so later
+    // tasks on the pool keep their own.
+    std::vector<char> prepared(pool.size(), 0);
+    pool.run(costs, [&](size_t i, unsigned index) {
+        if (composite.load(std::memory_order_relaxed))
+            return;
+        MillerRabinContext& worker = thread_miller_rabin_context();
+        MillerRabinKernel own = worker.kernel();
+        worker.set_kernel(kernel);
+        if (!prepared[index]) {
+            worker.prepare(n);
+            prepared[index] = 1;
+        }
+        if (!worker.test(witnesses_[i].get_mpz_t()))
+            composite.store(true, std::memory_order_relaxed);
+        worker.set_kernel(own);
+    });
+
+    return finish(!composite.load(std::memory_order_relaxed));
+}
+
+bool MillerRabinContext::is_prime_deterministic(const mpz_t n, int k) {
+    if (k == -1)
+        k = default_rounds(mpz_sizeinbase(n, 10));
+
+    int verdict = screen(n);
+    if (verdict >= 0)
+        return verdict;
+    if (fixed_width_ && mpz_sizeinbase(n, 2) <= 128)
+        return finish(fixed_width_rounds(n, k, nullptr, nullptr));
+
+    begin_count();
+    prepare(n);
+
+    bool result = true;
+    for (int i = 0; i < k && result; ++i) {
+        mpz_set_ui(a_, 2 + i);  // Set a = 2 + i
+        if (mpz_cmp(a_, n_minus_1_) >= 0)
+            break;  // every base below n - 1 has been tried
+
+        result = test(a_);
+    }
+
+    end_count();
+    return finish(result);
+}
+
+bool MillerRabinContext::is_bpsw_prime(const mpz_t n) {
+    int verdict = screen(n);
+    if (verdict >= 0)
+        return verdict;
+
+    bool result;
+    if (fixed_width_ && mpz_sizeinbase(n, 2) <= 128) {
+        // Below the bound the native bases are exact and cheaper than Lucas
+        uint128_t n128 = mpz_get_u128(n);
+        if (n128 < deterministic_u128_bound)
+            return finish(is_prime_u128_below_bound(n128));
+        result = strong_probable_prime(FixedMontgomery<uint128_t>(n128), uint128_t(2));
+    } else {
+        begin_count();
+        prepare(n);
+        mpz_set_ui(a_, 2);
+        result = test(a_);
+        end_count();
+    }
+
+    return finish(result && lucas_.strong_probable_prime(n));
+}
+
+bool MillerRabinContext::fixed_width_rounds(const mpz_t n, int k, WitnessSource* source, int* rounds_run) {
+    // The same bases and rounds as the mpz loops, so the verdict and
+    // rounds_run match them; a 64-bit n takes the narrower word
+    auto rounds = [&](const auto& mont) {
+        using Word = decltype(mont.modulus());
+        mpz_set(n_, n);
+        bool result = true;
+        for (int i = 0; i < k && result; ++i) {
+            Word a;
+            if (source) {
+                source->next(a_, n_);
+                a = static_cast<Word>(mpz_get_u128(a_));
+            } else {
+                a = static_cast<Word>(2 + i);
+                if (a >= mont.modulus() - 1)
+                    break;  // every base below n - 1 has been tried
+            }
+            if (rounds_run)
+                ++*rounds_run;
+            result = strong_probable_prime(mont, a);
+        }
+        return result;
+    };
+
+    uint128_t n128 = mpz_get_u128(n);
+    if (n128 >> 64 == 0)
+        return rounds(FixedMontgomery<uint64_t>(static_cast<uint64_t>(n128)));
+    return rounds(FixedMontgomery<uint128_t>(n128));
+}
+
+void MillerRabinContext::set_count_allocations(bool enabled) {
+    if (enabled == count_allocations_)
+        return;
+    count_allocations_ = enabled;
+    set_gmp_allocation_counting(enabled);
+}
+
+void MillerRabinContext::begin_count() {
+    if (count_allocations_)
+        count_start_ = gmp_allocation_count();
+}
+
+void MillerRabinContext::end_count() {
+    if (count_allocations_)
+        last_allocations_ = gmp_allocation_count() - count_start_;
+}
+
+bool MillerRabinContext::test_all(const mpz_t n, const std::vector<mpz_class>& bases) {
+    int verdict = screen(n);
+    if (verdict >= 0)
+        return verdict;
+
+    bool result = true;
+    if (fixed_width_ && mpz_sizeinbase(n, 2) <= 128) {
+        // One native round costs less than setting up the lockstep
+        FixedMontgomery<uint128_t> mont(mpz_get_u128(n));
+        for (size_t i = 0; i < bases.size() && result; ++i) {
+            mpz_mod(a_, bases[i].get_mpz_t(), n);
+            // A multiple of n fails, as in test(); strong_probable_prime would pass it
+            result = mpz_sgn(a_) != 0 && strong_probable_prime(mont, mpz_get_u128(a_));
+        }
+        return finish(result);
+    }
+
+    begin_count();
+    prepare(n);
+
+    if (kernel_ != MillerRabinKernel::Montgomery)
+        montgomery_.set_modulus(n_);
+    mp_size_t size = montgomery_.size();
+
+    // A small base u * w with u and w among the earlier bases needs no
+    // exponentiation of its own, as (u * w)^d is the product of their powers:
+    // of the bases 2, ..., k + 1 only the primes are exponentiated. The rest
+    // other than 2 go through one pow_many, 2 takes the doubling path, and
+    // the products follow in input order.
+    const size_t pending = static_cast<size_t>(-1);
+    auto find = [&](unsigned long value) {
+        for (size_t i = 0; i < lockstep_slots_.size(); ++i)
+            if (lockstep_slots_[i].first == value)
+                return i;
+        return lockstep_slots_.size();
+    };
+
+    lockstep_slots_.clear();
+    lockstep_products_.clear();
+    lockstep_bases_.resize(bases.size() * size);
+    size_t count = 0;
+    bool has_two = false;
+    for (const auto& a : bases) {
+        mpz_mod(a_, a.get_mpz_t(), n);
+        unsigned long value = mpz_fits_ulong_p(a_) ? mpz_get_ui(a_) : 0;
+        if (value == 2) {
+            if (!has_two)
+                lockstep_slots_.push_back({2, pending});
+            has_two = true;
+            continue;
+        }
+        unsigned long u = 2;
+        while (value >= 4 && u <= value / u &&
+               (value % u != 0 || find(u) == lockstep_slots_.size() || find(value / u) == lockstep_slots_.size()))
+            ++u;
+        if (value >= 4 && u <= value / u) {
+            lockstep_slots_.push_back({value, pending});
+            lockstep_products_.push_back({value, u});
+            continue;
+        }
+        montgomery_.to_montgomery(&lockstep_bases_[count * size], a_);
+        lockstep_slots_.push_back({value, count++});
+    }
+    lockstep_powers_.resize((count + has_two + lockstep_products_.size()) * size);
+    montgomery_.pow_many(lockstep_powers_.data(), lockstep_bases_.data(), count, d_);
+    if (has_two) {
+        montgomery_.pow_2(&lockstep_powers_[count * size], d_);
+        lockstep_slots_[find(2)].second = count++;
+    }
+    for (const auto& [value, u] : lockstep_products_) {
+        montgomery_.mul(&lockstep_powers_[count * size], &lockstep_powers_[lockstep_slots_[find(u)].second * size],
+                        &lockstep_powers_[lockstep_slots_[find(value / u)].second * size]);
+        lockstep_slots_[find(value)].second = count++;
+    }
+
+    settled_.assign(count, 0);
+    size_t open = count;
+    for (size_t c = 0; c < count; ++c) {
+        const mp_limb_t* x = &lockstep_powers_[c * size];
+        if (montgomery_.equal(x, montgomery_.one()) || montgomery_.equal(x, montgomery_.minus_one())) {
+            settled_[c] = 1;
+            --open;
+        }
+    }
+    for (mp_bitcnt_t r = 1; r < s_ && open > 0 && result; ++r) {
+        for (size_t c = 0; c < count && result; ++c) {
+            if (settled_[c])
+                continue;
+            mp_limb_t* x = &lockstep_powers_[c * size];
+            montgomery_.sqr(x, x);
+            if (montgomery_.equal(x, montgomery_.minus_one())) {
+                settled_[c] = 1;
+                --open;
+            } else if (montgomery_.equal(x, montgomery_.one())) {
+                result = false;
+            }
+        }
+    }
+    if (open > 0)
+        result = false;
+
+    end_count();
+    return finish(result);
+}
+
+bool MillerRabinContext::is_prime_deterministic_lockstep(const mpz_t n, int k) {
+    // Below 128 bits the native backend is exact and already a single pass
+    if (fixed_width_ && mpz_sizeinbase(n, 2) <= 128)
+        return is_prime_deterministic(n, k);
+    if (k == -1)
+        k = default_rounds(mpz_sizeinbase(n, 10));
+
+    // Bases below n - 1 only, as in is_prime_deterministic
+    witnesses_.clear();
+    for (int i = 0; i < k; ++i) {
+        if (mpz_cmp_ui(n, 3 + i) <= 0)
+            break;
+        witnesses_.emplace_back(2 + i);
+    }
+    return test_all(n, witnesses_);
+}
+
+MillerRabinContext& thread_miller_rabin_context() {
+    thread_local MillerRabinContext context;
+    return context;
+}
+
+bool is_probable_prime(const mpz_t n, int k, int* rounds_run) {
+    return thread_miller_rabin_context().is_probable_prime(n, k, thread_witness_source(), rounds_run);
+}
+
+bool is_probable_prime(const mpz_t n, WitnessSource& source, int k, int* rounds_run) {
+    return thread_miller_rabin_context().is_probable_prime(n, k, source, rounds_run);
+}
+
+bool is_probable_prime_parallel(const mpz_t n, int k, ThreadPool* pool) {
+    return thread_miller_rabin_context().is_probable_prime_parallel(n, k, thread_witness_source(),
+                                                                     pool ? *pool : default_thread_pool());
+}
+
+bool is_prime_deterministic_lockstep(const mpz_t n, int k) {
+    return thread_miller_rabin_context().is_prime_deterministic_lockstep(n, k);
+}
+
+bool is_prime_deterministic(const mpz_t n, int k) {
+    return thread_miller_rabin_context().is_prime_deterministic(n, k);
+}
+
+bool is_bpsw_prime(const mpz_t n) {
+    return thread_miller_rabin_context().is_bpsw_prime(n);
+}
+
+bool is_prime(const mpz_t n, TestMode mode, int k) {
+    switch (mode) {
+    case TestMode::Deterministic:
+        return is_prime_deterministic(n, k);
+    case TestMode::BailliePSW:
+        return is_bpsw_prime(n);
+    default:
+        return is_probable_prime(n, k);
+    }
+}
+
+// Relative cost of testing n: about bits modular products of size^2 limb
+// products each
+static double estimated_cost(const mpz_class& n) {
+    double limbs = static_cast<double>(mpz_size(n.get_mpz_t()));
+    return static_cast<double>(mpz_sizeinbase(n.get_mpz_t(), 2)) * limbs * limbs;
+}
+
+void is_prime_batch(std::span<const mpz_class> numbers, std::span<PrimalityResult> results, TestMode mode, int k, ThreadPool* pool) {
+    size_t count = std::min(numbers.size(), results.size());
+    std::vector<double> costs(count);
+    for (size_t i = 0; i < count; ++i)
+        costs[i] = estimated_cost(numbers[i]);
+
+    (pool ? *pool : default_thread_pool()).run(costs, [&](size_t i, unsigned) {
+        PrimalityResult& result = results[i];
+        result.rounds_run = 0;
+        if (mode == TestMode::Randomized)
+            result.prime = is_probable_prime(numbers[i].get_mpz_t(), k, &result.rounds_run);
+        else
+            result.prime = is_prime(numbers[i].get_mpz_t(), mode, k);
+    });
+}
+
+static std::vector<bool> batch_verdicts(const std::vector<mpz_class>& numbers, TestMode mode, int k) {
+    std::vector<PrimalityResult> results(numbers.size());
+    is_prime_batch(numbers, results, mode, k);
+    std::vector<bool> verdicts(numbers.size());
+    for (size_t i = 0; i < numbers.size(); ++i)
+        verdicts[i] = results[i].prime;
+    return verdicts;
+}
+
+std::vector<bool> is_probable_prime_batch(const std::vector<mpz_class>& numbers, int k) {
+    return batch_verdicts(numbers, TestMode::Randomized, k);
+}
+
+std::vector<bool> is_prime_deterministic_batch(const std::vector<mpz_class>& numbers, int k) {
+    return batch_verdicts(numbers, TestMode::Deterministic, k);
+}
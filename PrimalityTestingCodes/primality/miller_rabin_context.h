@@ -0,0 +1,125 @@
+#ifndef PRIMALITY_MILLER_RABIN_CONTEXT_H
+#define PRIMALITY_MILLER_RABIN_CONTEXT_H
+
+#include <utility>
+#include <vector>
+#include <gmp.h>
+#include <gmpxx.h>
+
+#include "primality/lucas.h"
+#include "primality/montgomery.h"
+#include "primality/prefilter.h"
+#include "primality/thread_pool.h"
+#include "primality/witness_source.h"
+
+// How a round raises the base to d and walks the squaring chain
+enum class MillerRabinKernel {
+    Powm,        // mpz_powm, then mpz_mul/mpz_mod squarings
+    Montgomery   // MontgomeryContext built once in prepare() and shared by every round
+};
+
+// Scratch state for Miller-Rabin that is kept between calls. Every mpz_t is
+// grown to fit the largest candidate seen so far and then reused, so testing
+// many numbers of similar size does not touch the heap.
+class MillerRabinContext {
+public:
+    MillerRabinContext();
+    // Preallocates scratch for candidates of up to `bits` bits
+    explicit MillerRabinContext(mp_bitcnt_t bits);
+    ~MillerRabinContext();
+
+    MillerRabinContext(const MillerRabinContext&) = delete;
+    MillerRabinContext& operator=(const MillerRabinContext&) = delete;
+
+    // Grows the scratch limbs to fit candidates of up to `bits` bits
+    void reserve(mp_bitcnt_t bits);
+
+    // Powm is the default: GMP's mpn_powm already works in Montgomery form with
+    // assembly REDC, and measured faster than the public-mpn Montgomery kernel
+    void set_kernel(MillerRabinKernel kernel) { kernel_ = kernel; }
+    MillerRabinKernel kernel() const { return kernel_; }
+
+    // Candidates of up to 128 bits go to the native FixedMontgomery backend,
+    // with the same bases and verdicts as the mpz rounds; on by default
+    void set_fixed_width(bool enabled) { fixed_width_ = enabled; }
+
+    // Small-prime screening run before the first round; tune its cutoffs
+    // with prefilter().set_limits(...)
+    Prefilter& prefilter() { return prefilter_; }
+
+    // Splits n - 1 = 2^s * d for the rounds that follow; n must be odd and > 3
+    void prepare(const mpz_t n);
+    // One Miller-Rabin round with base a against the prepared n
+    bool test(const mpz_t a);
+
+    // Randomized Miller-Rabin with k bases drawn from `source`
+    bool is_probable_prime(const mpz_t n, int k, WitnessSource& source, int* rounds_run = nullptr);
+    // Same verdict as is_probable_prime, with the k rounds spread over `pool`.
+    // The witnesses are drawn up front in the sequential order; once one
+    // proves n composite the rounds not yet started are skipped, while those
+    // already running finish. Each worker prepares for n once per call.
+    // Candidates of up to 128 bits, k < 2 and single-thread pools run
+    // sequentially.
+    // Must not be called from a task running on `pool`.
+    bool is_probable_prime_parallel(const mpz_t n, int k, WitnessSource& source, ThreadPool& pool);
+    // Miller-Rabin with the fixed bases 2, 3, ..., k + 1
+    bool is_prime_deterministic(const mpz_t n, int k);
+    // Throughput mode for callers that run every round anyway, such as
+    // certification: all bases share one Montgomery context and go through
+    // MontgomeryContext::pow_many in lockstep, a base of 2 takes the doubling
+    // path, a small composite base reuses the powers of its factors, and then
+    // the squaring chains advance together. Same verdict as test() on each
+    // base in turn, on every path: a base that is a multiple of n fails.
+    bool test_all(const mpz_t n, const std::vector<mpz_class>& bases);
+    // is_prime_deterministic through test_all
+    bool is_prime_deterministic_lockstep(const mpz_t n, int k);
+    // Baillie-PSW: a base-2 round followed by a strong Lucas test
+    bool is_bpsw_prime(const mpz_t n);
+
+    // Counter mode: record the number of GMP heap allocations made by each test
+    void set_count_allocations(bool enabled);
+    unsigned long last_allocations() const { return last_allocations_; }
+
+private:
+    // Returns the verdict for n <= 3 and even n, or -1 when rounds are needed
+    static int trivial_verdict(const mpz_t n);
+    // trivial_verdict followed by the prefilter, recording the deciding stage
+    int screen(const mpz_t n);
+    // Records the verdict of the rounds run on an n that survived screen()
+    bool finish(bool result);
+
+    // Rounds on an n of up to 128 bits with the native backend; a null
+    // source means the sequential bases 2, 3, ..., k + 1
+    bool fixed_width_rounds(const mpz_t n, int k, WitnessSource* source, int* rounds_run);
+
+    void begin_count();
+    void end_count();
+
+    mpz_t n_, n_minus_1_, d_, a_, x_;
+    MillerRabinKernel kernel_;
+    bool fixed_width_;
+    MontgomeryContext montgomery_;
+    Prefilter prefilter_;
+    LucasContext lucas_;
+    std::vector<mp_limb_t> base_, power_;  // Montgomery forms of a and a^(2^r * d)
+    std::vector<mpz_class> witnesses_;      // bases for is_probable_prime_parallel and the lockstep mode
+    std::vector<mp_limb_t> lockstep_bases_, lockstep_powers_;  // one residue per base, back to back
+    std::vector<std::pair<unsigned long, size_t>> lockstep_slots_;     // small base -> its power's slot
+    std::vector<std::pair<unsigned long, unsigned long>> lockstep_products_;  // base u * w -> u
+    std::vector<unsigned char> settled_;    // lockstep chains that reached -1
+    mp_bitcnt_t s_;
+    mp_bitcnt_t reserved_bits_;
+    bool count_allocations_;
+    unsigned long count_start_;
+    unsigned long last_allocations_;
+};
+
+// Context reused by the free functions on the calling thread
+MillerRabinContext& thread_miller_rabin_context();
+
+// Installs (or removes) GMP memory functions that count heap allocations.
+// The count is process wide, so concurrent tests are attributed together.
+void set_gmp_allocation_counting(bool enabled);
+unsigned long gmp_allocation_count();
+
+#endif
@@ -0,0 +1,190 @@
+#include "primality/montgomery.h"
+
+#include <algorithm>
+
+// Copies the absolute value of a into `size` limbs, zero padded
+static void export_limbs(mp_limb_t* r, const mpz_t a, mp_size_t size) {
+    mp_size_t used = static_cast<mp_size_t>(mpz_size(a));
+    std::copy(mpz_limbs_read(a), mpz_limbs_read(a) + used, r);
+    std::fill(r + used, r + size, mp_limb_t(0));
+}
+
+void MontgomeryContext::set_modulus(const mpz_t n) {
+    size_ = static_cast<mp_size_t>(mpz_size(n));
+    n_.resize(size_);
+    one_.resize(size_);
+    minus_one_.resize(size_);
+    r2_.resize(size_);
+    product_.resize(2 * size_);
+    export_limbs(n_.data(), n, size_);
+
+    // Newton iteration for n^-1 mod B, each step doubles the correct low bits
+    mp_limb_t n0 = n_[0];
+    mp_limb_t inverse = n0;  // n0 * n0 = 1 mod 8
+    for (int bits = 3; bits < GMP_NUMB_BITS; bits *= 2)
+        inverse *= 2 - n0 * inverse;
+    ninv_ = -inverse;
+
+    mpz_ptr power = power_.get_mpz_t();
+    mpz_set_ui(power, 0);
+    mpz_setbit(power, size_ * GMP_NUMB_BITS);
+    mpz_mod(power, power, n);
+    export_limbs(one_.data(), power, size_);
+
+    mpz_mul(power, power, power);
+    mpz_mod(power, power, n);
+    export_limbs(r2_.data(), power, size_);
+
+    mpn_sub_n(minus_one_.data(), n_.data(), one_.data(), size_);
+}
+
+void MontgomeryContext::redc(mp_limb_t* r, mp_limb_t* t) const {
+    // Each step clears limb i; its carry out belongs at limb i + size and is
+    // parked in the freed limb, then all carries are added in one pass
+    for (mp_size_t i = 0; i < size_; ++i) {
+        mp_limb_t u = t[i] * ninv_;
+        t[i] = mpn_addmul_1(t + i, n_.data(), size_, u);
+    }
+    mp_limb_t carry = mpn_add_n(r, t + size_, t, size_);
+
+    if (carry || mpn_cmp(r, n_.data(), size_) >= 0)
+        mpn_sub_n(r, r, n_.data(), size_);
+}
+
+void MontgomeryContext::mul(mp_limb_t* r, const mp_limb_t* a, const mp_limb_t* b) {
+    if (a == b) {
+        sqr(r, a);
+        return;
+    }
+    mpn_mul_n(product_.data(), a, b, size_);
+    redc(r, product_.data());
+}
+
+void MontgomeryContext::sqr(mp_limb_t* r, const mp_limb_t* a) {
+    mpn_sqr(product_.data(), a, size_);
+    redc(r, product_.data());
+}
+
+void MontgomeryContext::add(mp_limb_t* r, const mp_limb_t* a, const mp_limb_t* b) const {
+    mp_limb_t carry = mpn_add_n(r, a, b, size_);
+    if (carry || mpn_cmp(r, n_.data(), size_) >= 0)
+        mpn_sub_n(r, r, n_.data(), size_);
+}
+
+void MontgomeryContext::sub(mp_limb_t* r, const mp_limb_t* a, const mp_limb_t* b) const {
+    if (mpn_sub_n(r, a, b, size_))
+        mpn_add_n(r, r, n_.data(), size_);
+}
+
+void MontgomeryContext::half(mp_limb_t* r, const mp_limb_t* a) const {
+    // Division by 2 is linear, so it commutes with the Montgomery form
+    if (a[0] & 1) {
+        mp_limb_t carry = mpn_add_n(r, a, n_.data(), size_);
+        mpn_rshift(r, r, size_, 1);
+        r[size_ - 1] |= carry << (GMP_NUMB_BITS - 1);
+    } else {
+        mpn_rshift(r, a, size_, 1);
+    }
+}
+
+void MontgomeryContext::to_montgomery(mp_limb_t* r, const mpz_t a) {
+    // a * R = REDC(a * R^2)
+    std::fill(product_.begin(), product_.end(), mp_limb_t(0));
+    mp_size_t used = static_cast<mp_size_t>(mpz_size(a));
+    if (used != 0)
+        mpn_mul(product_.data(), r2_.data(), size_, mpz_limbs_read(a), used);
+    redc(r, product_.data());
+}
+
+void MontgomeryContext::from_montgomery(mpz_t r, const mp_limb_t* a) {
+    std::copy(a, a + size_, product_.begin());
+    std::fill(product_.begin() + size_, product_.end(), mp_limb_t(0));
+
+    mp_limb_t* limbs = mpz_limbs_write(r, size_);
+    redc(limbs, product_.data());
+    mpz_limbs_finish(r, size_);
+}
+
+int MontgomeryContext::window_bits(mp_bitcnt_t bits) {
+    // Widths that minimise table setup plus one multiply per window
+    static const mp_bitcnt_t limits[] = {7, 25, 81, 241, 673, 1793};
+    int window = 1;
+    for (mp_bitcnt_t limit : limits) {
+        if (bits <= limit)
+            break;
+        ++window;
+    }
+    return window;
+}
+
+void MontgomeryContext::pow(mp_limb_t* r, const mp_limb_t* base, const mpz_t exp) {
+    pow_many(r, base, 1, exp);
+}
+
+void MontgomeryContext::pow_many(mp_limb_t* r, const mp_limb_t* bases, size_t count, const mpz_t exp) {
+    if (mpz_sgn(exp) == 0) {
+        for (size_t c = 0; c < count; ++c)
+            std::copy(one_.begin(), one_.end(), r + c * size_);
+        return;
+    }
+
+    mp_bitcnt_t bits = mpz_sizeinbase(exp, 2);
+    int window = window_bits(bits);
+
+    // Table of base c: entry j = base^(2j + 1), at table_[(c * entries + j) * size_]
+    size_t entries = size_t(1) << (window - 1);
+    table_.resize(count * entries * size_);
+    for (size_t c = 0; c < count; ++c) {
+        mp_limb_t* table = &table_[c * entries * size_];
+        mp_limb_t* x = r + c * size_;
+        std::copy(bases + c * size_, bases + (c + 1) * size_, table);
+        if (entries > 1) {
+            sqr(x, table);  // x = base^2 while the table is built
+            for (size_t j = 1; j < entries; ++j)
+                mul(table + j * size_, table + (j - 1) * size_, x);
+        }
+    }
+
+    bool started = false;
+    long i = static_cast<long>(bits) - 1;
+    while (i >= 0) {
+        if (!mpz_tstbit(exp, i)) {
+            for (size_t c = 0; c < count; ++c)
+                sqr(r + c * size_, r + c * size_);
+            --i;
+            continue;
+        }
+
+        // Longest window ending in a set bit
+        long low = std::max(i - window + 1, 0l);
+        while (!mpz_tstbit(exp, low))
+            ++low;
+        unsigned long value = 0;
+        for (long j = i; j >= low; --j)
+            value = (value << 1) | mpz_tstbit(exp, j);
+
+        // Chains alternate at every squaring, keeping their products interleaved
+        if (started)
+            for (long j = i; j >= low; --j)
+                for (size_t c = 0; c < count; ++c)
+                    sqr(r + c * size_, r + c * size_);
+        for (size_t c = 0; c < count; ++c) {
+            const mp_limb_t* entry = &table_[(c * entries + (value >> 1)) * size_];
+            if (started)
+                mul(r + c * size_, r + c * size_, entry);
+            else
+                std::copy(entry, entry + size_, r + c * size_);
+        }
+        started = true;
+        i = low - 1;
+    }
+}
+
+void MontgomeryContext::pow_2(mp_limb_t* r, const mpz_t exp) {
+    std::copy(one_.begin(), one_.end(), r);
+    for (long i = static_cast<long>(mpz_sizeinbase(exp, 2)) - 1; i >= 0; --i) {
+        sqr(r, r);
+        if (mpz_tstbit(exp, i))
+            add(r, r, r);
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef PRIMALITY_MONTGOMERY_H
+#define PRIMALITY_MONTGOMERY_H
+
+#include <cstddef>
+#include <vector>
+#include <gmp.h>
+#include <gmpxx.h>
+
+// Montgomery arithmetic modulo an odd n > 1 on the mpn layer, with R = B^size
+// for the limb base B. Residues are arrays of size() limbs kept fully reduced
+// in [0, n), so they can be compared limb for limb. A context is built once per
+// candidate and shared by every witness and squaring of that candidate.
+class MontgomeryContext {
+public:
+    MontgomeryContext() = default;
+    explicit MontgomeryContext(const mpz_t n) { set_modulus(n); }
+
+    // Recomputes -n^-1 mod B, R mod n and R^2 mod n; buffers are reused
+    void set_modulus(const mpz_t n);
+
+    mp_size_t size() const { return size_; }
+    const mp_limb_t* modulus() const { return n_.data(); }
+    // R mod n and n - (R mod n), the Montgomery forms of 1 and -1
+    const mp_limb_t* one() const { return one_.data(); }
+    const mp_limb_t* minus_one() const { return minus_one_.data(); }
+
+    // r = a * b / R mod n; r may alias a or b
+    void mul(mp_limb_t* r, const mp_limb_t* a, const mp_limb_t* b);
+    void sqr(mp_limb_t* r, const mp_limb_t* a);
+    // r = a + b, a - b and a / 2 mod n; r may alias the inputs
+    void add(mp_limb_t* r, const mp_limb_t* a, const mp_limb_t* b) const;
+    void sub(mp_limb_t* r, const mp_limb_t* a, const mp_limb_t* b) const;
+    void half(mp_limb_t* r, const mp_limb_t* a) const;
+
+    void to_montgomery(mp_limb_t* r, const mpz_t a);  // a in [0, n)
+    void from_montgomery(mpz_t r, const mp_limb_t* a);
+
+    // r = base^exp in Montgomery form by left-to-right sliding windows.
+    // r must not alias base.
+    void pow(mp_limb_t* r, const mp_limb_t* base, const mpz_t exp);
+    // r[i] = bases[i]^exp for `count` residues stored back to back. The
+    // window schedule depends only on exp, so one scan drives every chain and
+    // each step runs the count independent products next to each other.
+    void pow_many(mp_limb_t* r, const mp_limb_t* bases, size_t count, const mpz_t exp);
+    // r = 2^exp in Montgomery form; each multiplication by the base is a
+    // doubling, so only the squarings cost a product
+    void pow_2(mp_limb_t* r, const mpz_t exp);
+
+    bool equal(const mp_limb_t* a, const mp_limb_t* b) const { return mpn_cmp(a, b, size_) == 0; }
+    bool is_zero(const mp_limb_t* a) const { return mpn_zero_p(a, size_); }
+
+    // Sliding-window width used for an exponent of `bits` bits
+    static int window_bits(mp_bitcnt_t bits);
+
+private:
+    // r = t / R mod n for a 2 * size() limb t, which is clobbered
+    void redc(mp_limb_t* r, mp_limb_t* t) const;
+
+    mp_size_t size_ = 0;
+    mp_limb_t ninv_ = 0;  // -n^-1 mod B
+    std::vector<mp_limb_t> n_, one_, minus_one_, r2_;
+    std::vector<mp_limb_t> product_;  // 2 * size() limbs
+    std::vector<mp_limb_t> table_;    // odd powers of each base for pow_many()
+    mpz_class power_;                 // R and R^2 while the modulus is set
+};
+
+#endif
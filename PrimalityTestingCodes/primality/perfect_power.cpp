@@ -0,0 +1,167 @@
+#include "primality/perfect_power.h"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "primality/prefilter.h"
+
+namespace {
+
+// Residue screens per exponent; each rejects a non-power with probability
+// about 1 - 1/p, so a handful leaves almost nothing for mpz_root
+constexpr size_t screens_per_exponent = 4;
+// First screens of this many consecutive exponents share one mpz_fdiv_ui by
+// their product, which fits in a word since every modulus is below 2^14
+constexpr size_t exponents_per_group = 4;
+
+struct ExponentScreen {
+    uint32_t count = 0;
+    std::array<uint32_t, screens_per_exponent> moduli{};
+};
+
+struct ScreenTable {
+    // screens[i] holds primes q = 1 mod p for p = small_prime_table[i]; p = 2
+    // has none since mpz_perfect_square_p already screens squares
+    std::vector<ExponentScreen> screens;
+    // Product of moduli[0] over exponents [1 + g * exponents_per_group, ...)
+    std::vector<unsigned long> group_products;
+};
+
+const ScreenTable& screen_table() {
+    static const ScreenTable table = [] {
+        ScreenTable t;
+        t.screens.resize(small_prime_table.size());
+        // Hand each q to the odd primes dividing q - 1
+        for (size_t j = 1; j < small_prime_table.size(); ++j) {
+            uint32_t q = small_prime_table[j];
+            uint32_t rest = q - 1;
+            for (size_t i = 1; i < j && small_prime_table[i] <= rest; ++i) {
+                uint32_t p = small_prime_table[i];
+                if (rest % p != 0)
+                    continue;
+                while (rest % p == 0)
+                    rest /= p;
+                ExponentScreen& screen = t.screens[i];
+                if (screen.count < screens_per_exponent)
+                    screen.moduli[screen.count++] = q;
+            }
+        }
+        for (size_t i = 1; i < t.screens.size(); i += exponents_per_group) {
+            unsigned long product = 1;
+            for (size_t k = i; k < i + exponents_per_group && k < t.screens.size(); ++k)
+                if (t.screens[k].count > 0)
+                    product *= t.screens[k].moduli[0];
+            t.group_products.push_back(product);
+        }
+        return t;
+    }();
+    return table;
+}
+
+uint32_t pow_mod(uint32_t base, uint32_t exp, uint32_t mod) {
+    uint64_t result = 1, b = base;
+    while (exp > 0) {
+        if (exp & 1)
+            result = result * b % mod;
+        b = b * b % mod;
+        exp >>= 1;
+    }
+    return static_cast<uint32_t>(result);
+}
+
+// Whether a nonzero residue mod q is a p-th power there; zero says nothing
+// since q may divide m
+bool is_power_residue(uint32_t residue, uint32_t p, uint32_t q) {
+    return residue == 0 || pow_mod(residue, (q - 1) / p, q) == 1;
+}
+
+bool is_word_prime(unsigned long x) {
+    for (unsigned long d = 2; d * d <= x; ++d)
+        if (x % d == 0)
+            return false;
+    return x >= 2;
+}
+
+// Roots of at most this many bits are located in floating point
+constexpr double float_root_bits = 32;
+
+// Whether n = m^p, filling m if so. A root of few bits is 2^(log2(n) / p) to
+// within about 1e-5 from the double log2(n), so unless that is next to an
+// integer n is no p-th power and the only exact check is one mpz_ui_pow_ui.
+bool exact_root(mpz_class& m, const mpz_class& n, unsigned long p, double log2n) {
+    double root_bits = log2n / p;
+    if (root_bits > float_root_bits)
+        return mpz_root(m.get_mpz_t(), n.get_mpz_t(), p) != 0;
+
+    double approx = std::exp2(root_bits);
+    double nearest = std::round(approx);
+    if (std::fabs(approx - nearest) > 1e-3)
+        return false;
+    mpz_ui_pow_ui(m.get_mpz_t(), static_cast<unsigned long>(nearest), p);
+    if (m != n)
+        return false;
+    m = static_cast<unsigned long>(nearest);
+    return true;
+}
+
+}  // namespace
+
+unsigned long perfect_power_exponent(const mpz_class& n, mpz_class* root) {
+    if (n < 2)
+        return 0;
+    mpz_class m;
+
+    if (mpz_perfect_square_p(n.get_mpz_t())) {
+        if (root)
+            mpz_sqrt(root->get_mpz_t(), n.get_mpz_t());
+        return 2;
+    }
+
+    // m >= 2 bounds the exponent by log2(n)
+    unsigned long max_p = mpz_sizeinbase(n.get_mpz_t(), 2) - 1;
+    long exponent;
+    double mantissa = mpz_get_d_2exp(&exponent, n.get_mpz_t());
+    double log2n = exponent + std::log2(mantissa);
+
+    const ScreenTable& table = screen_table();
+    size_t group = SIZE_MAX;
+    unsigned long group_residue = 0;
+    for (size_t i = 1; i < small_prime_table.size() && small_prime_table[i] <= max_p; ++i) {
+        uint32_t p = small_prime_table[i];
+        // Small roots are cheaper to rule out in floating point than by residues
+        if (log2n / p > float_root_bits) {
+            const ExponentScreen& screen = table.screens[i];
+            if (screen.count > 0) {
+                if ((i - 1) / exponents_per_group != group) {
+                    group = (i - 1) / exponents_per_group;
+                    group_residue = mpz_fdiv_ui(n.get_mpz_t(), table.group_products[group]);
+                }
+                bool candidate = is_power_residue(group_residue % screen.moduli[0], p, screen.moduli[0]);
+                for (uint32_t k = 1; candidate && k < screen.count; ++k)
+                    candidate = is_power_residue(mpz_fdiv_ui(n.get_mpz_t(), screen.moduli[k]), p, screen.moduli[k]);
+                if (!candidate)
+                    continue;
+            }
+        }
+        if (exact_root(m, n, p, log2n)) {
+            if (root)
+                *root = m;
+            return p;
+        }
+    }
+    // Exponents past the table only occur for n beyond 2^16384
+    for (unsigned long p = small_prime_limit + 1; p <= max_p; p += 2) {
+        if (is_word_prime(p) && exact_root(m, n, p, log2n)) {
+            if (root)
+                *root = m;
+            return p;
+        }
+    }
+    return 0;
+}
+
+bool is_perfect_power(const mpz_class& n) {
+    return perfect_power_exponent(n) != 0;
+}
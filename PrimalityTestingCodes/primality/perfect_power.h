@@ -0,0 +1,17 @@
+#ifndef PRIMALITY_PERFECT_POWER_H
+#define PRIMALITY_PERFECT_POWER_H
+
+#include <gmp.h>
+#include <gmpxx.h>
+
+// Smallest prime p with n = m^p for an integer m, or 0 if n (>= 2) is not a
+// perfect power. Only prime exponents are tried, since m^(ab) = (m^a)^b.
+// Each one is first screened by whether n mod q is a p-th power residue for a
+// few small primes q = 1 mod p, and only survivors pay for an exact mpz_root.
+// If root is given it receives m.
+unsigned long perfect_power_exponent(const mpz_class& n, mpz_class* root = nullptr);
+
+// True if n = m^b for some integers m and b >= 2
+bool is_perfect_power(const mpz_class& n);
+
+#endif
@@ -0,0 +1,139 @@
+#include "primality/polynomial.h"
+
+#include <algorithm>
+
+PolyModN::PolyModN(const mpz_class& n, size_t r) : r_(r) {
+    limbs_ = static_cast<mp_size_t>(mpz_size(n.get_mpz_t()));
+    n_.assign(mpz_limbs_read(n.get_mpz_t()), mpz_limbs_read(n.get_mpz_t()) + limbs_);
+
+    // A product coefficient is a sum of up to r terms below n^2
+    field_bits_ = 2 * mpz_sizeinbase(n.get_mpz_t(), 2) + mpz_sizeinbase(mpz_class(r).get_mpz_t(), 2);
+    field_limbs_ = static_cast<mp_size_t>((field_bits_ + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS);
+    packed_limbs_ = static_cast<mp_size_t>((r * field_bits_ + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS);
+
+    coeffs_.assign(r * limbs_, 0);
+    packed_a_.assign(packed_limbs_, 0);
+    packed_b_.assign(packed_limbs_, 0);
+    product_.assign(2 * packed_limbs_ + 1, 0);
+    field_.assign(field_limbs_, 0);
+    sum_.assign(field_limbs_ + 1, 0);
+    quotient_.assign(field_limbs_ + 2, 0);
+    top_.assign(limbs_, 0);
+}
+
+void PolyModN::get_coefficient(mpz_t c, size_t i) const {
+    mp_limb_t* limbs = mpz_limbs_write(c, limbs_);
+    std::copy(coefficient(i), coefficient(i) + limbs_, limbs);
+    mpz_limbs_finish(c, limbs_);
+}
+
+void PolyModN::set_constant(unsigned long c) {
+    std::fill(coeffs_.begin(), coeffs_.end(), mp_limb_t(0));
+    coeffs_[0] = c;
+}
+
+void PolyModN::pack(mp_limb_t* packed) const {
+    std::fill(packed, packed + packed_limbs_, mp_limb_t(0));
+    for (size_t i = 0; i < r_; ++i) {
+        size_t bit = i * field_bits_;
+        mp_limb_t* out = packed + bit / GMP_NUMB_BITS;
+        unsigned shift = bit % GMP_NUMB_BITS;
+        const mp_limb_t* c = coefficient(i);
+        if (shift == 0) {
+            for (mp_size_t k = 0; k < limbs_; ++k)
+                out[k] |= c[k];
+            continue;
+        }
+        mp_limb_t carry = 0;
+        for (mp_size_t k = 0; k < limbs_; ++k) {
+            out[k] |= (c[k] << shift) | carry;
+            carry = c[k] >> (GMP_NUMB_BITS - shift);
+        }
+        // Nonzero only if c reaches that limb, which then lies inside the field
+        if (carry)
+            out[limbs_] |= carry;
+    }
+}
+
+void PolyModN::extract(mp_limb_t* field, size_t j) const {
+    size_t bit = j * field_bits_;
+    const mp_limb_t* in = &product_[bit / GMP_NUMB_BITS];
+    unsigned shift = bit % GMP_NUMB_BITS;
+    for (mp_size_t k = 0; k < field_limbs_; ++k)
+        field[k] = shift == 0 ? in[k] : (in[k] >> shift) | (in[k + 1] << (GMP_NUMB_BITS - shift));
+
+    unsigned excess = static_cast<unsigned>(field_limbs_ * GMP_NUMB_BITS - field_bits_);
+    if (excess)
+        field[field_limbs_ - 1] &= GMP_NUMB_MASK >> excess;
+}
+
+void PolyModN::reduce(mp_limb_t* r, const mp_limb_t* x, mp_size_t size) {
+    if (size < limbs_) {
+        std::copy(x, x + size, r);
+        std::fill(r + size, r + limbs_, mp_limb_t(0));
+        return;
+    }
+    mpn_tdiv_qr(quotient_.data(), r, 0, x, size, n_.data(), limbs_);
+}
+
+void PolyModN::fold() {
+    for (size_t i = 0; i < r_; ++i) {
+        extract(field_.data(), i);
+        extract(sum_.data(), i + r_);
+        sum_[field_limbs_] = mpn_add_n(sum_.data(), sum_.data(), field_.data(), field_limbs_);
+        reduce(&coeffs_[i * limbs_], sum_.data(), field_limbs_ + 1);
+    }
+}
+
+void PolyModN::sqr() {
+    pack(packed_a_.data());
+    mpn_sqr(product_.data(), packed_a_.data(), packed_limbs_);
+    fold();
+}
+
+void PolyModN::mul(const PolyModN& other) {
+    if (&other == this) {
+        sqr();
+        return;
+    }
+    pack(packed_a_.data());
+    other.pack(packed_b_.data());
+    mpn_mul_n(product_.data(), packed_a_.data(), packed_b_.data(), packed_limbs_);
+    fold();
+}
+
+void PolyModN::mul_x_plus_a(unsigned long a) {
+    // Multiplying by x rotates the coefficients up by one, since x^r = 1.
+    // Walking down keeps c_(i-1) unmodified until it has been used.
+    std::copy(coefficient(r_ - 1), coefficient(r_ - 1) + limbs_, top_.begin());
+    for (size_t i = r_; i-- > 0;) {
+        const mp_limb_t* previous = i > 0 ? coefficient(i - 1) : top_.data();
+        std::copy(previous, previous + limbs_, sum_.begin());
+        sum_[limbs_] = mpn_addmul_1(sum_.data(), coefficient(i), limbs_, a);
+        reduce(&coeffs_[i * limbs_], sum_.data(), limbs_ + 1);
+    }
+}
+
+bool PolyModN::pow_x_plus_a(unsigned long a, const mpz_t e, const std::atomic<bool>* cancel) {
+    set_constant(1);
+    for (long i = static_cast<long>(mpz_sizeinbase(e, 2)) - 1; i >= 0; --i) {
+        if (cancel && cancel->load(std::memory_order_relaxed))
+            return false;
+        sqr();
+        if (mpz_tstbit(e, i))
+            mul_x_plus_a(a);
+    }
+    return true;
+}
+
+bool PolyModN::equals_x_power_plus(size_t k, unsigned long c) const {
+    for (size_t i = 0; i < r_; ++i) {
+        mp_limb_t expected = (i == 0 ? c : 0) + (i == k ? 1 : 0);
+        if (limbs_ == 1 && expected == n_[0])
+            expected = 0;  // c + 1 = n
+        const mp_limb_t* limbs = coefficient(i);
+        if (limbs[0] != expected || (limbs_ > 1 && !mpn_zero_p(limbs + 1, limbs_ - 1)))
+            return false;
+    }
+    return true;
+}
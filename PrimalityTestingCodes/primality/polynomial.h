@@ -0,0 +1,66 @@
+#ifndef PRIMALITY_POLYNOMIAL_H
+#define PRIMALITY_POLYNOMIAL_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include <gmp.h>
+#include <gmpxx.h>
+
+// A polynomial in Z_n[x]/(x^r - 1). The r coefficients, each in [0, n), sit
+// in one contiguous buffer at limbs() limbs apiece, constant term first.
+// Every buffer a product needs is sized in the constructor, so squarings and
+// multiplies reuse them and do not allocate.
+class PolyModN {
+public:
+    PolyModN(const mpz_class& n, size_t r);
+
+    size_t size() const { return r_; }
+    mp_size_t limbs() const { return limbs_; }
+    const mp_limb_t* coefficient(size_t i) const { return &coeffs_[i * limbs_]; }
+    void get_coefficient(mpz_t c, size_t i) const;
+
+    // this = c, with c < n
+    void set_constant(unsigned long c);
+
+    // this = this^2 and this = this * other, in place. Both operands are
+    // packed into one integer each (Kronecker substitution, a bit field per
+    // coefficient just wide enough for r * n^2) and multiplied once; the
+    // product is folded mod x^r - 1 before each coefficient is reduced.
+    void sqr();
+    void mul(const PolyModN& other);
+
+    // this = this * (x + a) in O(r): c_i = c_(i-1) + a * c_i, with a < n
+    void mul_x_plus_a(unsigned long a);
+
+    // this = (x + a)^e, left to right so every multiply is mul_x_plus_a.
+    // Returns false, leaving this unspecified, if *cancel is set between two
+    // squarings.
+    bool pow_x_plus_a(unsigned long a, const mpz_t e, const std::atomic<bool>* cancel = nullptr);
+
+    // Whether this equals x^k + c, with k < r and c < n
+    bool equals_x_power_plus(size_t k, unsigned long c) const;
+
+private:
+    void pack(mp_limb_t* packed) const;
+    // field = bit field j of product_
+    void extract(mp_limb_t* field, size_t j) const;
+    // coeffs_ = product_ folded mod x^r - 1 and reduced mod n
+    void fold();
+    // r = x mod n for an x of `size` limbs
+    void reduce(mp_limb_t* r, const mp_limb_t* x, mp_size_t size);
+
+    size_t r_;
+    mp_size_t limbs_;   // limbs of n, and of each coefficient
+    size_t field_bits_;       // bits per packed coefficient
+    mp_size_t field_limbs_;   // limbs to hold one field
+    mp_size_t packed_limbs_;  // limbs of a packed polynomial
+    std::vector<mp_limb_t> n_;
+    std::vector<mp_limb_t> coeffs_;              // r * limbs
+    std::vector<mp_limb_t> packed_a_, packed_b_;
+    std::vector<mp_limb_t> product_;             // 2 * packed_limbs + 1, the last limb stays zero
+    std::vector<mp_limb_t> field_, sum_, quotient_;
+    std::vector<mp_limb_t> top_;                 // c_(r-1) while mul_x_plus_a rotates
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include "primality/prefilter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+
+namespace {
+
+std::atomic<bool> counting{false};
+std::atomic<unsigned long> stage_counts[static_cast<size_t>(PrefilterStage::Count)];
+
+}  // namespace
+
+void set_prefilter_counting(bool enabled) {
+    counting.store(enabled, std::memory_order_relaxed);
+}
+
+void record_prefilter_stage(PrefilterStage stage) {
+    if (counting.load(std::memory_order_relaxed))
+        stage_counts[static_cast<size_t>(stage)].fetch_add(1, std::memory_order_relaxed);
+}
+
+PrefilterStats prefilter_stats() {
+    auto count = [](PrefilterStage stage) {
+        return stage_counts[static_cast<size_t>(stage)].load(std::memory_order_relaxed);
+    };
+    PrefilterStats stats;
+    stats.trivial = count(PrefilterStage::Trivial);
+    stats.gcd = count(PrefilterStage::Gcd);
+    stats.trial_division = count(PrefilterStage::TrialDivision);
+    stats.miller_rabin = count(PrefilterStage::MillerRabin);
+    stats.proven_prime = count(PrefilterStage::ProvenPrime);
+    stats.probable_prime = count(PrefilterStage::ProbablePrime);
+    stats.tested = stats.trivial + stats.gcd + stats.trial_division + stats.miller_rabin +
+                   stats.proven_prime + stats.probable_prime;
+    return stats;
+}
+
+void reset_prefilter_stats() {
+    for (auto& count : stage_counts)
+        count.store(0, std::memory_order_relaxed);
+}
+
+void Prefilter::set_limits(uint32_t gcd_limit, uint32_t trial_limit) {
+    gcd_limit_ = std::min(gcd_limit, small_prime_limit - 1);
+    trial_limit_ = std::min(trial_limit, small_prime_limit - 1);
+    uint32_t limit = std::max(gcd_limit_, trial_limit_);
+    proven_bound_ = static_cast<unsigned long>(limit + 1) * (limit + 1);
+
+    // Skip 2, the caller has already rejected even n
+    auto first = small_prime_table.begin() + 1;
+    auto gcd_end = std::upper_bound(first, small_prime_table.end(), gcd_limit_);
+    primorial_ = 1;
+    for (auto p = first; p < gcd_end; ++p)
+        primorial_ *= static_cast<unsigned long>(*p);
+
+    trial_begin_ = gcd_end - small_prime_table.begin();
+    size_t trial_end = std::upper_bound(small_prime_table.begin(), small_prime_table.end(), trial_limit_) -
+                       small_prime_table.begin();
+    products_.clear();
+    run_end_.clear();
+    unsigned long product = 1;
+    for (size_t i = trial_begin_; i < trial_end; ++i) {
+        unsigned long p = small_prime_table[i];
+        if (product > ULONG_MAX / p) {
+            products_.push_back(product);
+            run_end_.push_back(i);
+            product = 1;
+        }
+        product *= p;
+    }
+    if (product != 1) {
+        products_.push_back(product);
+        run_end_.push_back(trial_end);
+    }
+}
+
+int Prefilter::screen(const mpz_t n) {
+    uint32_t limit = std::max(gcd_limit_, trial_limit_);
+    if (limit == 0)
+        return -1;
+
+    if (mpz_cmp_ui(n, limit) <= 0) {
+        bool prime = std::binary_search(small_prime_table.begin(), small_prime_table.end(),
+                                        static_cast<uint32_t>(mpz_get_ui(n)));
+        record_prefilter_stage(prime ? PrefilterStage::ProvenPrime : PrefilterStage::TrialDivision);
+        return prime;
+    }
+
+    // n is above every prime in range, so any common factor is a proper one
+    if (primorial_ != 1) {
+        mpz_gcd(gcd_.get_mpz_t(), n, primorial_.get_mpz_t());
+        if (mpz_cmp_ui(gcd_.get_mpz_t(), 1) != 0) {
+            record_prefilter_stage(PrefilterStage::Gcd);
+            return 0;
+        }
+    }
+
+    size_t begin = trial_begin_;
+    for (size_t run = 0; run < products_.size(); ++run) {
+        unsigned long r = mpz_tdiv_ui(n, products_[run]);
+        for (size_t i = begin; i < run_end_[run]; ++i) {
+            if (r % small_prime_table[i] == 0) {
+                record_prefilter_stage(PrefilterStage::TrialDivision);
+                return 0;
+            }
+        }
+        begin = run_end_[run];
+    }
+
+    if (mpz_cmp_ui(n, proven_bound_) < 0) {
+        record_prefilter_stage(PrefilterStage::ProvenPrime);
+        return 1;
+    }
+    return -1;
+}
@@ -0,0 +1,110 @@
+#ifndef PRIMALITY_PREFILTER_H
+#define PRIMALITY_PREFILTER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <gmp.h>
+#include <gmpxx.h>
+
+// Primes below this bound are tabulated, which caps the trial division cutoff
+constexpr uint32_t small_prime_limit = 1u << 14;
+
+constexpr std::array<bool, small_prime_limit> small_prime_sieve() {
+    std::array<bool, small_prime_limit> composite{};
+    composite[0] = composite[1] = true;
+    for (uint32_t p = 2; p * p < small_prime_limit; ++p) {
+        if (composite[p])
+            continue;
+        for (uint32_t m = p * p; m < small_prime_limit; m += p)
+            composite[m] = true;
+    }
+    return composite;
+}
+
+constexpr size_t small_prime_count() {
+    auto composite = small_prime_sieve();
+    size_t count = 0;
+    for (bool c : composite)
+        count += !c;
+    return count;
+}
+
+constexpr std::array<uint32_t, small_prime_count()> make_small_prime_table() {
+    auto composite = small_prime_sieve();
+    std::array<uint32_t, small_prime_count()> primes{};
+    size_t i = 0;
+    for (uint32_t p = 2; p < small_prime_limit; ++p) {
+        if (!composite[p])
+            primes[i++] = p;
+    }
+    return primes;
+}
+
+// All primes below small_prime_limit, in increasing order
+inline constexpr auto small_prime_table = make_small_prime_table();
+
+// Where a candidate's verdict was decided
+enum class PrefilterStage {
+    Trivial,        // n <= 1 or even (or n is 2 or 3)
+    Gcd,            // common factor with the primorial of the gcd range
+    TrialDivision,  // divisible by a prime in the trial division range
+    MillerRabin,    // composite by a witness
+    ProvenPrime,    // prime without running a witness
+    ProbablePrime,  // passed every round
+    Count
+};
+
+// Number of candidates decided at each stage since the last reset
+struct PrefilterStats {
+    unsigned long tested = 0;
+    unsigned long trivial = 0;
+    unsigned long gcd = 0;
+    unsigned long trial_division = 0;
+    unsigned long miller_rabin = 0;
+    unsigned long proven_prime = 0;
+    unsigned long probable_prime = 0;
+};
+
+// Counting is off by default; the counters are process wide
+void set_prefilter_counting(bool enabled);
+void record_prefilter_stage(PrefilterStage stage);
+PrefilterStats prefilter_stats();
+void reset_prefilter_stats();
+
+// Cheap screening run before any modular exponentiation. The odd primes up to
+// gcd_limit are tested at once with a gcd against their product; the primes
+// above that, up to trial_limit, with mpz_tdiv_ui against runs of primes whose
+// product fits in an unsigned long.
+class Prefilter {
+public:
+    static constexpr uint32_t default_gcd_limit = 211;
+    static constexpr uint32_t default_trial_limit = 1024;
+
+    Prefilter() : Prefilter(default_gcd_limit, default_trial_limit) {}
+    Prefilter(uint32_t gcd_limit, uint32_t trial_limit) { set_limits(gcd_limit, trial_limit); }
+
+    // Limits are clamped to small_prime_limit; set_limits(0, 0) turns the
+    // prefilter off and a trial_limit at or below gcd_limit skips trial division
+    void set_limits(uint32_t gcd_limit, uint32_t trial_limit);
+    uint32_t gcd_limit() const { return gcd_limit_; }
+    uint32_t trial_limit() const { return trial_limit_; }
+
+    // For odd n > 3: 0 if n has a prime factor up to the limits, 1 if that
+    // proves n prime (n is a tabulated prime or below the square of the
+    // largest limit), -1 if Miller-Rabin is needed. Records the stage.
+    int screen(const mpz_t n);
+
+private:
+    uint32_t gcd_limit_ = 0;
+    uint32_t trial_limit_ = 0;
+    unsigned long proven_bound_ = 0;         // every composite below this has a factor in range
+    mpz_class primorial_;                    // product of the odd primes up to gcd_limit
+    mpz_class gcd_;                          // scratch for the gcd stage
+    std::vector<unsigned long> products_;    // one product per run of trial primes
+    std::vector<size_t> run_end_;            // small_prime_table index past each run
+    size_t trial_begin_ = 0;                 // small_prime_table index of the first trial prime
+};
+
+#endif
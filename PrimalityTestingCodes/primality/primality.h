@@ -0,0 +1,85 @@
+#ifndef PRIMALITY_H
+#define PRIMALITY_H
+
+#include <cstddef>
+#include <span>
+#include <vector>
+#include <gmp.h>
+#include <gmpxx.h>
+
+#include "primality/aks.h"
+#include "primality/batch_prefilter.h"
+#include "primality/certificate.h"
+#include "primality/ecpp.h"
+#include "primality/factor.h"
+#include "primality/fixed_width.h"
+#include "primality/lucas.h"
+#include "primality/miller_rabin_context.h"
+#include "primality/prefilter.h"
+#include "primality/prime_gen.h"
+#include "primality/sieve.h"
+#include "primality/thread_pool.h"
+#include "primality/trial_division.h"
+#include "primality/witness_source.h"
+
+// Number of Miller-Rabin rounds used when k == -1: max(5, factor * ceil(log2(digits)))
+int default_rounds(size_t num_digits, int factor = 2);
+
+// Perform (base^exp) % mod using GMP
+void mod_exp(mpz_t result, const mpz_t base, const mpz_t exp, const mpz_t mod);
+
+// Returns true if n passes one Miller-Rabin test with base a.
+// Expects n - 1 = 2^s * d with d odd; x is scratch owned by the caller.
+bool miller_test(const mpz_t n, const mpz_t n_minus_1, const mpz_t d, mp_bitcnt_t s, const mpz_t a, mpz_t x);
+
+// Randomized Miller-Rabin with k bases drawn uniformly from [2, n - 2] by the
+// calling thread's witness source (or `source`). If rounds_run is given it
+// receives the number of witnesses that were tried.
+bool is_probable_prime(const mpz_t n, int k = -1, int* rounds_run = nullptr);
+bool is_probable_prime(const mpz_t n, WitnessSource& source, int k = -1, int* rounds_run = nullptr);
+
+// Latency mode for one large n: the k rounds of is_probable_prime run
+// concurrently on `pool` (the default pool if null). Once a witness proves n
+// composite, the rounds not yet started are skipped; rounds already running
+// finish. The verdict matches is_probable_prime.
+bool is_probable_prime_parallel(const mpz_t n, int k = -1, ThreadPool* pool = nullptr);
+
+// Miller-Rabin with the fixed bases 2, 3, ..., k + 1
+bool is_prime_deterministic(const mpz_t n, int k = -1);
+// Same bases and verdict, with every round run in lockstep (see
+// MillerRabinContext::test_all); faster when n is expected to be prime
+bool is_prime_deterministic_lockstep(const mpz_t n, int k = -1);
+
+// Baillie-PSW: a strong base-2 round and a strong Lucas test with Selfridge's
+// parameters. About three rounds of work and no known counterexample.
+bool is_bpsw_prime(const mpz_t n);
+
+enum class TestMode {
+    Randomized,     // is_probable_prime with k random bases
+    Deterministic,  // is_prime_deterministic with bases 2, ..., k + 1
+    BailliePSW      // is_bpsw_prime; k is ignored
+};
+
+bool is_prime(const mpz_t n, TestMode mode, int k = -1);
+
+struct PrimalityResult {
+    bool prime = false;
+    int rounds_run = 0;  // witnesses tried, for TestMode::Randomized
+};
+
+// Tests numbers[i] into results[i] on `pool` (the default pool if null) and
+// returns when all are done; only the first min(sizes) entries are touched.
+// Tasks are scheduled by estimated cost, so mixed sizes balance across the
+// workers. Each worker draws witnesses from its own stream, but which worker
+// tests which number varies from run to run.
+void is_prime_batch(std::span<const mpz_class> numbers, std::span<PrimalityResult> results,
+                    TestMode mode = TestMode::Randomized, int k = -1, ThreadPool* pool = nullptr);
+
+// Batch variants on the default pool, one verdict per input in the same order
+std::vector<bool> is_probable_prime_batch(const std::vector<mpz_class>& numbers, int k = -1);
+std::vector<bool> is_prime_deterministic_batch(const std::vector<mpz_class>& numbers, int k = -1);
+
+// Generate a random number with `num_digits` digits.
+void generate_random_mpz(mpz_t result, gmp_randstate_t state, size_t num_digits);
+
+#endif
@@ -0,0 +1,306 @@
+#include "primality/prime_gen.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <stdexcept>
+
+#include "primality/primality.h"
+
+namespace {
+
+// Survivors were already screened far past the prefilter's limits, so the
+// contexts testing them skip it
+struct SurvivorContext {
+    MillerRabinContext context;
+    SurvivorContext() { context.prefilter().set_limits(0, 0); }
+};
+
+MillerRabinContext& survivor_context() {
+    thread_local SurvivorContext survivor;
+    return survivor.context;
+}
+
+uint64_t pow_mod(uint64_t base, uint64_t exp, uint64_t mod) {
+    uint64_t result = 1;
+    for (base %= mod; exp > 0; exp >>= 1) {
+        if (exp & 1)
+            result = result * base % mod;
+        base = base * base % mod;
+    }
+    return result;
+}
+
+// 2^(n-1) = 1 mod n, one exponentiation to throw out most survivors before
+// their full rounds
+bool fermat_base_2(const mpz_t n, mpz_class& scratch) {
+    mpz_sub_ui(scratch.get_mpz_t(), n, 1);
+    mpz_class two = 2;
+    mpz_powm(scratch.get_mpz_t(), two.get_mpz_t(), scratch.get_mpz_t(), n);
+    return scratch == 1;
+}
+
+// First probable prime in base + i * step from a random i in [0, count),
+// wrapping to i = 0 at count; base and step above the sieving primes
+void search_progression(mpz_t result, const mpz_class& base, const mpz_class& step, const mpz_class& count,
+                        gmp_randstate_t state, int k, PrimeSearchStats& stats) {
+    MillerRabinContext& context = survivor_context();
+    WitnessSource& source = thread_witness_source();
+    thread_local CandidateSieve sieve;
+    mpz_class i, start, candidate, scratch;
+    mpz_urandomm(i.get_mpz_t(), state, count.get_mpz_t());
+
+    for (;;) {
+        start = base + i * step;
+        sieve.sieve(start.get_mpz_t(), step.get_mpz_t());
+        for (size_t offset = 0; offset < sieve.window(); ++offset) {
+            if (i + offset >= count) {
+                i = -static_cast<long>(sieve.window());
+                break;
+            }
+            ++stats.candidates;
+            if (!sieve.survivor(offset))
+                continue;
+            ++stats.sieve_survivors;
+            candidate = start + offset * step;
+            if (!fermat_base_2(candidate.get_mpz_t(), scratch))
+                continue;
+            ++stats.fermat_passes;
+            if (context.is_probable_prime(candidate.get_mpz_t(), k, source)) {
+                mpz_set(result, candidate.get_mpz_t());
+                return;
+            }
+        }
+        i += sieve.window();
+    }
+}
+
+}  // namespace
+
+CandidateSieve::CandidateSieve(size_t window, uint32_t sieve_limit) : composite_(window, 0) {
+    for (size_t i = 1; i < small_prime_table.size() && small_prime_table[i] < sieve_limit; ++i)
+        primes_.push_back(small_prime_table[i]);
+    residues_.resize(primes_.size());
+
+    unsigned long product = 1;
+    for (size_t i = 0; i < primes_.size(); ++i) {
+        if (product > ULONG_MAX / primes_[i]) {
+            products_.push_back(product);
+            run_end_.push_back(i);
+            product = 1;
+        }
+        product *= primes_[i];
+    }
+    if (product > 1) {
+        products_.push_back(product);
+        run_end_.push_back(primes_.size());
+    }
+}
+
+void CandidateSieve::reduce(const mpz_t x, std::vector<uint32_t>& out) const {
+    out.resize(primes_.size());
+    size_t begin = 0;
+    for (size_t run = 0; run < products_.size(); ++run) {
+        unsigned long r = mpz_fdiv_ui(x, products_[run]);
+        for (size_t j = begin; j < run_end_[run]; ++j)
+            out[j] = static_cast<uint32_t>(r % primes_[j]);
+        begin = run_end_[run];
+    }
+}
+
+void CandidateSieve::sieve(const mpz_t base) {
+    sieve_window(base, nullptr, false);
+}
+
+void CandidateSieve::sieve(const mpz_t base, const mpz_t step) {
+    sieve_window(base, step, false);
+}
+
+void CandidateSieve::sieve_safe(const mpz_t base) {
+    sieve_window(base, nullptr, true);
+}
+
+void CandidateSieve::sieve_window(const mpz_t base, const mpz_t step, bool safe) {
+    reduce(base, residues_);
+    if (step)
+        reduce(step, step_residues_);
+
+    std::fill(composite_.begin(), composite_.end(), 0);
+    // Only a base below the last prime can put a sieving prime in the window
+    bool small_base = !step && mpz_cmp_ui(base, primes_.empty() ? 0 : primes_.back()) <= 0;
+    unsigned long base_value = small_base ? mpz_get_ui(base) : 0;
+    size_t window = composite_.size();
+    for (size_t j = 0; j < primes_.size(); ++j) {
+        uint64_t p = primes_[j];
+        uint64_t r = residues_[j];
+        uint64_t inverse = (p + 1) / 2;
+        if (step) {
+            if (step_residues_[j] == 0) {
+                // Every candidate is base mod p
+                if (r == 0)
+                    std::fill(composite_.begin(), composite_.end(), 1);
+                continue;
+            }
+            inverse = pow_mod(step_residues_[j], p - 2, p);
+        }
+
+        // base + i * step = 0 mod p  <=>  i = -base / step mod p
+        uint64_t i = (p - r) % p * inverse % p;
+        if (small_base && base_value + 2 * i == p)
+            i += p;
+        for (; i < window; i += p)
+            composite_[i] = 1;
+
+        if (safe) {
+            // 2x + 1 = 0 mod p  <=>  x = (p - 1) / 2 mod p
+            i = ((p - 1) / 2 + p - r) % p * inverse % p;
+            if (small_base && 2 * (base_value + 2 * i) + 1 == p)
+                i += p;
+            for (; i < window; i += p)
+                composite_[i] = 1;
+        }
+    }
+}
+
+void next_prime(mpz_t result, const mpz_t n, int k) {
+    if (mpz_cmp_ui(n, 2) < 0) {
+        mpz_set_ui(result, 2);
+        return;
+    }
+
+    MillerRabinContext& context = survivor_context();
+    WitnessSource& source = thread_witness_source();
+    thread_local CandidateSieve sieve;
+    mpz_class base(n), candidate;
+    base += 1;
+    if (mpz_even_p(base.get_mpz_t())) {
+        if (base == 2) {
+            mpz_set_ui(result, 2);
+            return;
+        }
+        base += 1;
+    }
+    if (k == -1)
+        k = default_rounds(mpz_sizeinbase(base.get_mpz_t(), 10));
+
+    for (;; base += 2 * sieve.window()) {
+        sieve.sieve(base.get_mpz_t());
+        for (size_t i = 0; i < sieve.window(); ++i) {
+            if (!sieve.survivor(i))
+                continue;
+            candidate = base + 2 * i;
+            if (context.is_probable_prime(candidate.get_mpz_t(), k, source)) {
+                mpz_set(result, candidate.get_mpz_t());
+                return;
+            }
+        }
+    }
+}
+
+void random_prime(mpz_t result, mp_bitcnt_t bits, gmp_randstate_t state, int k) {
+    mpz_class start, bottom;
+    mpz_setbit(bottom.get_mpz_t(), bits - 1);
+    mpz_urandomb(start.get_mpz_t(), state, bits - 1);
+    start += bottom;
+
+    // next_prime is strict, so search from start - 1 to include start itself
+    start -= 1;
+    next_prime(result, start.get_mpz_t(), k);
+    if (mpz_sizeinbase(result, 2) > bits) {
+        bottom -= 1;
+        next_prime(result, bottom.get_mpz_t(), k);
+    }
+}
+
+void random_safe_prime(mpz_t result, mp_bitcnt_t bits, gmp_randstate_t state, int k, PrimeSearchStats* stats) {
+    auto begin = std::chrono::high_resolution_clock::now();
+    PrimeSearchStats local;
+    MillerRabinContext& context = survivor_context();
+    WitnessSource& source = thread_witness_source();
+    thread_local CandidateSieve sieve;
+
+    // q is an odd number of bits - 1 bits, so 2q + 1 has exactly `bits`
+    mpz_class bottom, top, base, q, p, scratch;
+    mpz_setbit(bottom.get_mpz_t(), bits - 2);
+    mpz_setbit(top.get_mpz_t(), bits - 1);
+    mpz_urandomb(base.get_mpz_t(), state, bits - 2);
+    base += bottom;
+    mpz_setbit(base.get_mpz_t(), 0);
+    if (k == -1)
+        k = default_rounds(static_cast<size_t>(bits * 0.30103) + 1);
+
+    for (bool found = false; !found;) {
+        sieve.sieve_safe(base.get_mpz_t());
+        for (size_t i = 0; i < sieve.window(); ++i) {
+            q = base + 2 * i;
+            if (q >= top) {
+                // Wrap to the smallest odd q of the range
+                base = bottom + 1 - 2 * static_cast<long>(sieve.window());
+                break;
+            }
+            ++local.candidates;
+            if (!sieve.survivor(i))
+                continue;
+            ++local.sieve_survivors;
+            p = 2 * q + 1;
+            if (!fermat_base_2(p.get_mpz_t(), scratch))
+                continue;
+            ++local.fermat_passes;
+            if (context.is_probable_prime(q.get_mpz_t(), k, source) && context.is_probable_prime(p.get_mpz_t(), k, source)) {
+                mpz_set(result, p.get_mpz_t());
+                found = true;
+                break;
+            }
+        }
+        base += 2 * sieve.window();
+    }
+
+    local.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - begin).count();
+    if (stats)
+        *stats = local;
+}
+
+void random_strong_prime(mpz_t result, mp_bitcnt_t bits, gmp_randstate_t state, int k, PrimeSearchStats* stats) {
+    // Below this, half - 32 wraps around or leaves no room for the multipliers
+    if (bits < 96)
+        throw std::invalid_argument("random_strong_prime: bits must be at least 96");
+
+    auto begin = std::chrono::high_resolution_clock::now();
+    PrimeSearchStats local;
+    if (k == -1)
+        k = default_rounds(static_cast<size_t>(bits * 0.30103) + 1);
+
+    // s and r come out near bits / 2 - 16 bits, so r * s leaves about 2^30
+    // multipliers j for p = p0 + 2jrs within the range
+    mp_bitcnt_t half = bits / 2;
+    mpz_class s, t, r, p0, rs2, bottom, top, count, first;
+    random_prime(s.get_mpz_t(), half - 16, state, k);
+    random_prime(t.get_mpz_t(), half - 32, state, k);
+
+    // r = 2it + 1 for i from 2^14 up
+    mpz_class step = 2 * t;
+    mpz_class count_i = mpz_class(1) << 14;
+    search_progression(r.get_mpz_t(), step * count_i + 1, step, count_i, state, k, local);
+
+    // p0 = 2 (s^(r-2) mod r) s - 1 is 1 mod r and -1 mod s
+    mpz_class exponent = r - 2;
+    mpz_powm(p0.get_mpz_t(), s.get_mpz_t(), exponent.get_mpz_t(), r.get_mpz_t());
+    p0 = 2 * p0 * s - 1;
+
+    // p = p0 + 2jrs with j chosen so that p has exactly `bits` bits
+    rs2 = 2 * r * s;
+    mpz_setbit(bottom.get_mpz_t(), bits - 1);
+    mpz_setbit(top.get_mpz_t(), bits);
+    mpz_class j_lo = bottom - p0;
+    mpz_cdiv_q(j_lo.get_mpz_t(), j_lo.get_mpz_t(), rs2.get_mpz_t());
+    mpz_class j_hi = top - 1 - p0;
+    mpz_fdiv_q(j_hi.get_mpz_t(), j_hi.get_mpz_t(), rs2.get_mpz_t());
+    count = j_hi - j_lo + 1;
+    first = p0 + j_lo * rs2;
+    search_progression(result, first, rs2, count, state, k, local);
+
+    local.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - begin).count();
+    if (stats)
+        *stats = local;
+}
@@ -0,0 +1,90 @@
+#ifndef PRIMALITY_PRIME_GEN_H
+#define PRIMALITY_PRIME_GEN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <gmp.h>
+#include <gmpxx.h>
+
+#include "primality/prefilter.h"
+
+// Marks which of the odd candidates base, base + 2, ..., base + 2 * (window - 1)
+// have a factor among the odd tabulated primes below sieve_limit. base is
+// reduced once per run of primes whose product fits in an unsigned long, so a
+// window costs a few hundred mpz_fdiv_ui calls however many primes it covers.
+class CandidateSieve {
+public:
+    static constexpr size_t default_window = 4096;
+
+    explicit CandidateSieve(size_t window = default_window, uint32_t sieve_limit = small_prime_limit);
+
+    size_t window() const { return composite_.size(); }
+
+    // base must be odd; a candidate equal to one of the sieving primes survives
+    void sieve(const mpz_t base);
+    // Candidates base + i * step instead, for base and step above the sieving
+    // primes (Gordon's progressions)
+    void sieve(const mpz_t base, const mpz_t step);
+    // Safe-prime mode: candidate q also goes when 2q + 1 has a small factor,
+    // so survivors are the q worth testing for a safe prime 2q + 1
+    void sieve_safe(const mpz_t base);
+
+    bool survivor(size_t i) const { return !composite_[i]; }
+
+    // Residue of the last base modulo primes()[j]
+    const std::vector<uint32_t>& primes() const { return primes_; }
+    const std::vector<uint32_t>& residues() const { return residues_; }
+
+private:
+    // x mod primes_[j] into out[j]
+    void reduce(const mpz_t x, std::vector<uint32_t>& out) const;
+    // A null step means 2
+    void sieve_window(const mpz_t base, const mpz_t step, bool safe);
+
+    std::vector<uint32_t> primes_;
+    std::vector<unsigned long> products_;  // one product per run of primes
+    std::vector<size_t> run_end_;          // primes_ index past each run
+    std::vector<uint32_t> residues_;
+    std::vector<uint32_t> step_residues_;
+    std::vector<unsigned char> composite_;
+};
+
+// Work done by one prime search
+struct PrimeSearchStats {
+    unsigned long candidates = 0;       // values the search stepped over
+    unsigned long sieve_survivors = 0;  // candidates left by the window sieve
+    unsigned long fermat_passes = 0;    // survivors that passed the base-2 Fermat check
+    double seconds = 0;
+
+    double candidates_per_second() const { return seconds > 0 ? candidates / seconds : 0; }
+};
+
+// Smallest probable prime greater than n. Candidates are taken a sieved window
+// at a time and only the survivors pay for Miller-Rabin (k rounds, or
+// default_rounds when -1).
+void next_prime(mpz_t result, const mpz_t n, int k = -1);
+
+// Random probable prime of exactly `bits` bits (bits >= 2): the first prime
+// at or after a uniform start in [2^(bits-1), 2^bits), wrapping to the bottom
+// of the range if none is left above it. Like every incremental search this
+// favours primes that follow long gaps.
+void random_prime(mpz_t result, mp_bitcnt_t bits, gmp_randstate_t state, int k = -1);
+
+// Random safe prime p = 2q + 1 of exactly `bits` bits (bits >= 3) with q
+// prime. One window sieve removes q whenever q or 2q + 1 has a small factor;
+// a survivor then needs 2q + 1 to pass a base-2 Fermat check before q gets
+// its k rounds, and p its own k rounds last. If stats is given it receives
+// the work done.
+void random_safe_prime(mpz_t result, mp_bitcnt_t bits, gmp_randstate_t state, int k = -1,
+                       PrimeSearchStats* stats = nullptr);
+
+// Random strong prime of exactly `bits` bits (bits >= 96) by Gordon's
+// algorithm: p - 1 has a large prime factor r, p + 1 a large prime factor s
+// and r - 1 a large prime factor t, each of about bits / 2 - 16 bits or
+// more. The searches for r and p sieve their progressions the same way, and
+// stats covers those two searches. Throws std::invalid_argument if bits < 96.
+void random_strong_prime(mpz_t result, mp_bitcnt_t bits, gmp_randstate_t state, int k = -1,
+                         PrimeSearchStats* stats = nullptr);
+
+#endif
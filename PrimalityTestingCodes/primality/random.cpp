@@ -0,0 +1,16 @@
+#include "primality/primality.h"
+
+// Generate a random number with `num_digits` digits.
+void generate_random_mpz(mpz_t result, gmp_randstate_t state, size_t num_digits) {
+    mpz_t lower, upper;
+    mpz_inits(lower, upper, NULL);
+
+    mpz_ui_pow_ui(lower, 10, num_digits - 1); // 10^(d-1)
+    mpz_ui_pow_ui(upper, 10, num_digits);     // 10^d
+    mpz_sub(upper, upper, lower);             // Range = 10^d - 10^(d-1)
+
+    mpz_urandomm(result, state, upper);       // result in [0, range)
+    mpz_add(result, result, lower);           // result in [10^(d-1), 10^d)
+
+    mpz_clears(lower, upper, NULL);
+}
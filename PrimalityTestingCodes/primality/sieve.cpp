@@ -0,0 +1,238 @@
+#include "primality/sieve.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// Primes handled by the presieve pattern rather than crossed off
+constexpr std::array<uint32_t, 6> wheel_primes = {2, 3, 5, 7, 11, 13};
+// A byte holds the 8 odd numbers of 16 consecutive integers, so the pattern
+// for 3 * 5 * 7 * 11 * 13 repeats every 15015 bytes
+constexpr size_t pattern_bytes = 3 * 5 * 7 * 11 * 13;
+
+constexpr size_t l1_segment_bytes = 32 * 1024;
+constexpr size_t l2_segment_bytes = 256 * 1024;
+
+const std::vector<unsigned char>& presieve_pattern() {
+    static const std::vector<unsigned char> pattern = [] {
+        std::vector<unsigned char> bytes(pattern_bytes, 0);
+        for (size_t b = 0; b < pattern_bytes; ++b)
+            for (unsigned bit = 0; bit < 8; ++bit) {
+                uint64_t x = 16 * b + 2 * bit + 1;
+                if (x % 3 && x % 5 && x % 7 && x % 11 && x % 13)
+                    bytes[b] |= static_cast<unsigned char>(1u << bit);
+            }
+        return bytes;
+    }();
+    return pattern;
+}
+
+uint64_t isqrt(uint64_t x) {
+    uint64_t r = static_cast<uint64_t>(std::sqrt(static_cast<double>(x)));
+    while (r * r > x)
+        --r;
+    while ((r + 1) * (r + 1) <= x)
+        ++r;
+    return r;
+}
+
+// Bit j of a segment starting at `start` (a multiple of 16) stands for
+// start + 2j + 1; set bits are the primes of the segment above 13, given
+// every prime of `primes` (all >= 17) up to sqrt(start + 16 * bytes)
+void sieve_segment(uint64_t start, size_t bytes, const std::vector<uint32_t>& primes, std::vector<uint64_t>& bits) {
+    bits.resize(bytes / 8);
+    auto* out = reinterpret_cast<unsigned char*>(bits.data());
+    const auto& pattern = presieve_pattern();
+    size_t offset = (start / 16) % pattern_bytes;
+    for (size_t filled = 0; filled < bytes;) {
+        size_t chunk = std::min(bytes - filled, pattern_bytes - offset);
+        std::memcpy(out + filled, pattern.data() + offset, chunk);
+        filled += chunk;
+        offset = 0;
+    }
+    if (start == 0)
+        bits[0] &= ~uint64_t(1);  // 1 is not prime
+
+    uint64_t end = start + 16 * bytes;
+    uint64_t nbits = 8 * bytes;
+    for (uint32_t p : primes) {
+        uint64_t square = uint64_t(p) * p;
+        if (square >= end)
+            break;
+        uint64_t multiple = std::max(square, (start + p) / p * p);
+        if (multiple % 2 == 0)
+            multiple += p;
+        for (uint64_t j = (multiple - start - 1) / 2; j < nbits; j += p)
+            bits[j / 64] &= ~(uint64_t(1) << (j % 64));
+    }
+}
+
+// Bits [first, last) of a segment starting at `start` that lie in [lo, hi)
+void bit_range(uint64_t start, size_t nbits, uint64_t lo, uint64_t hi, uint64_t& first, uint64_t& last) {
+    first = lo > start ? (lo - start) / 2 : 0;
+    last = std::min<uint64_t>(nbits, (hi - start) / 2);
+}
+
+uint64_t count_bits(const std::vector<uint64_t>& bits, uint64_t first, uint64_t last) {
+    uint64_t count = 0;
+    for (uint64_t w = first / 64; w * 64 < last; ++w) {
+        uint64_t word = bits[w];
+        if (w == first / 64)
+            word &= ~uint64_t(0) << (first % 64);
+        if ((w + 1) * 64 > last)
+            word &= ~uint64_t(0) >> (64 - last % 64);
+        count += std::popcount(word);
+    }
+    return count;
+}
+
+void emit_bits(const std::vector<uint64_t>& bits, uint64_t start, uint64_t first, uint64_t last,
+               const std::function<void(uint64_t)>& callback) {
+    for (uint64_t w = first / 64; w * 64 < last; ++w) {
+        uint64_t word = bits[w];
+        if (w == first / 64)
+            word &= ~uint64_t(0) << (first % 64);
+        if ((w + 1) * 64 > last)
+            word &= ~uint64_t(0) >> (64 - last % 64);
+        for (; word; word &= word - 1)
+            callback(start + 2 * (64 * w + std::countr_zero(word)) + 1);
+    }
+}
+
+// Odd primes from 17 up to limit, sieved by the same segments on `workers`
+std::vector<uint32_t> sieving_primes(uint64_t limit, ThreadPool& workers) {
+    std::vector<uint32_t> primes;
+    if (limit < 17)
+        return primes;
+
+    // Primes up to sqrt(limit) fit in one plain sieve
+    uint64_t root = isqrt(limit);
+    std::vector<bool> composite(root + 1, false);
+    for (uint64_t i = 3; i * i <= root; i += 2)
+        for (uint64_t m = i * i; m <= root; m += 2 * i)
+            composite[m] = true;
+    std::vector<uint32_t> small;
+    for (uint64_t i = 17; i <= root; i += 2)
+        if (!composite[i])
+            small.push_back(static_cast<uint32_t>(i));
+
+    const uint64_t span = 16 * l1_segment_bytes;
+    size_t segments = static_cast<size_t>(limit / span + 1);
+    std::vector<std::vector<uint32_t>> found(segments);
+    std::vector<std::vector<uint64_t>> buffers(workers.size());
+    auto sieve = [&](size_t segment, unsigned worker) {
+        uint64_t start = segment * span;
+        const std::vector<uint64_t>& bits = buffers[worker];
+        sieve_segment(start, l1_segment_bytes, small, buffers[worker]);
+        found[segment].reserve(count_bits(bits, 0, 8 * l1_segment_bytes));
+        for (size_t w = 0; w < bits.size(); ++w)
+            for (uint64_t word = bits[w]; word; word &= word - 1) {
+                uint64_t p = start + 2 * (64 * w + std::countr_zero(word)) + 1;
+                if (p > limit)
+                    return;
+                found[segment].push_back(static_cast<uint32_t>(p));
+            }
+    };
+    if (segments == 1) {
+        sieve(0, 0);
+    } else {
+        std::vector<double> costs(segments, 1.0);
+        workers.run(costs, sieve);
+    }
+    size_t total = 0;
+    for (const auto& part : found)
+        total += part.size();
+    primes.reserve(total);
+    for (const auto& part : found)
+        primes.insert(primes.end(), part.begin(), part.end());
+    return primes;
+}
+
+// How [lo, hi) is cut into segments
+struct SegmentPlan {
+    uint64_t first_start = 0;
+    size_t bytes = 0;
+    size_t count = 0;
+    std::vector<uint32_t> primes;
+
+    SegmentPlan(uint64_t lo, uint64_t hi, ThreadPool& workers) {
+        uint64_t root = isqrt(hi - 1);
+        primes = sieving_primes(root, workers);
+        bytes = root < 16 * l1_segment_bytes ? l1_segment_bytes : l2_segment_bytes;
+        first_start = lo / 16 * 16;
+        uint64_t span = 16 * bytes;
+        count = static_cast<size_t>((hi - first_start + span - 1) / span);
+    }
+
+    uint64_t start(size_t segment) const { return first_start + segment * 16 * bytes; }
+};
+
+}  // namespace
+
+uint64_t count_primes(uint64_t lo, uint64_t hi, ThreadPool* pool) {
+    if (hi <= lo)
+        return 0;
+    uint64_t count = 0;
+    for (uint32_t p : wheel_primes)
+        count += lo <= p && p < hi;
+    if (hi <= 17)
+        return count;
+
+    ThreadPool& workers = pool ? *pool : default_thread_pool();
+    SegmentPlan plan(lo, hi, workers);
+    std::vector<std::vector<uint64_t>> buffers(workers.size());
+    std::vector<uint64_t> counts(workers.size(), 0);
+    auto sieve = [&](size_t segment, unsigned worker) {
+        uint64_t start = plan.start(segment);
+        sieve_segment(start, plan.bytes, plan.primes, buffers[worker]);
+        uint64_t first, last;
+        bit_range(start, 8 * plan.bytes, lo, hi, first, last);
+        counts[worker] += count_bits(buffers[worker], first, last);
+    };
+    if (plan.count == 1) {
+        sieve(0, 0);
+    } else {
+        std::vector<double> costs(plan.count, 1.0);
+        workers.run(costs, sieve);
+    }
+    for (uint64_t c : counts)
+        count += c;
+    return count;
+}
+
+void for_each_prime(uint64_t lo, uint64_t hi, const std::function<void(uint64_t)>& callback, ThreadPool* pool) {
+    if (hi <= lo)
+        return;
+    for (uint32_t p : wheel_primes)
+        if (lo <= p && p < hi)
+            callback(p);
+    if (hi <= 17)
+        return;
+
+    // Each batch sieves two segments per worker into their own buffers while
+    // the caller is idle, then hands them to the callback in order
+    ThreadPool& workers = pool ? *pool : default_thread_pool();
+    SegmentPlan plan(lo, hi, workers);
+    size_t batch = plan.count == 1 ? 1 : 2 * workers.size();
+    std::vector<std::vector<uint64_t>> buffers(batch);
+    for (size_t base = 0; base < plan.count; base += batch) {
+        size_t size = std::min(batch, plan.count - base);
+        auto sieve = [&](size_t i, unsigned) { sieve_segment(plan.start(base + i), plan.bytes, plan.primes, buffers[i]); };
+        if (size == 1) {
+            sieve(0, 0);
+        } else {
+            std::vector<double> costs(size, 1.0);
+            workers.run(costs, sieve);
+        }
+        for (size_t i = 0; i < size; ++i) {
+            uint64_t start = plan.start(base + i), first, last;
+            bit_range(start, 8 * plan.bytes, lo, hi, first, last);
+            emit_bits(buffers[i], start, first, last, callback);
+        }
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef PRIMALITY_SIEVE_H
+#define PRIMALITY_SIEVE_H
+
+#include <cstdint>
+#include <functional>
+
+#include "primality/thread_pool.h"
+
+// Segmented sieve of Eratosthenes over [lo, hi) for hi <= 2^63. Segments
+// hold odd numbers only, one bit each, and are sized for L1 when the sieving
+// primes are small or L2 once most of them skip whole segments. Each segment
+// starts from a copy of a presieved pattern for 3, 5, 7, 11 and 13 and is
+// then crossed off by the primes up to sqrt(hi), which are kept as one table
+// of about 4 bytes per prime (200 MB when hi is near 10^18).
+//
+// Segments are spread over `pool` (the default pool if null), which must not
+// be running a batch already.
+
+// Number of primes p with lo <= p < hi
+uint64_t count_primes(uint64_t lo, uint64_t hi, ThreadPool* pool = nullptr);
+
+// Calls callback(p) for every prime lo <= p < hi in increasing order, from
+// the calling thread; segments are sieved a batch at a time ahead of it
+void for_each_prime(uint64_t lo, uint64_t hi, const std::function<void(uint64_t)>& callback,
+                    ThreadPool* pool = nullptr);
+
+#endif
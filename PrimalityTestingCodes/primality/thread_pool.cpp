@@ -0,0 +1,108 @@
+#include "primality/thread_pool.h"
+#include "primality/witness_source.h"
+
+#include <algorithm>
+#include <numeric>
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < threads; ++i)
+        queues_.push_back(std::make_unique<Queue>());
+    for (unsigned i = 0; i < threads; ++i)
+        threads_.emplace_back(&ThreadPool::worker_loop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    start_.notify_all();
+    for (auto& thread : threads_)
+        thread.join();
+}
+
+void ThreadPool::run(std::span<const double> costs, const std::function<void(size_t, unsigned)>& task) {
+    if (costs.empty())
+        return;
+
+    // Longest processing time first: each task goes to the least loaded worker
+    std::vector<size_t> order(costs.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return costs[a] > costs[b]; });
+
+    // Every worker is idle between runs, and run_mutex_ keeps other callers
+    // out, so the deques can be filled unlocked
+    std::lock_guard<std::mutex> run_lock(run_mutex_);
+    std::vector<double> load(queues_.size(), 0.0);
+    for (size_t i : order) {
+        size_t worker = std::min_element(load.begin(), load.end()) - load.begin();
+        load[worker] += costs[i];
+        queues_[worker]->tasks.push_back(i);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &task;
+        active_ = size();
+        ++generation_;
+    }
+    start_.notify_all();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [&] { return active_ == 0; });
+    task_ = nullptr;
+}
+
+bool ThreadPool::pop(unsigned worker, size_t& task) {
+    {
+        Queue& own = *queues_[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+    for (unsigned offset = 1; offset < queues_.size(); ++offset) {
+        Queue& victim = *queues_[(worker + offset) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::worker_loop(unsigned index) {
+    seed_thread_witness_source(worker_stream(index));
+
+    uint64_t seen = 0;
+    for (;;) {
+        const std::function<void(size_t, unsigned)>* task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_)
+                return;
+            seen = generation_;
+            task = task_;
+        }
+
+        size_t i;
+        while (pop(index, i))
+            (*task)(i, index);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--active_ == 0)
+            done_.notify_all();
+    }
+}
+
+ThreadPool& default_thread_pool() {
+    static ThreadPool pool;
+    return pool;
+}
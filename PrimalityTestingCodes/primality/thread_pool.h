@@ -0,0 +1,67 @@
+#ifndef PRIMALITY_THREAD_POOL_H
+#define PRIMALITY_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads with one task deque each. run() deals the
+// tasks out longest-first to the least loaded worker; a worker takes its own
+// tasks from the front and, once its deque is empty, steals from the back of
+// the others. Workers live as long as the pool, so their thread_local
+// Miller-Rabin contexts and witness sources are reused across batches.
+class ThreadPool {
+public:
+    // threads == 0 uses std::thread::hardware_concurrency()
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(threads_.size()); }
+
+    // Calls task(i, worker) for every i in [0, costs.size()) and returns when
+    // all have finished. costs[i] is the estimated relative cost of task i.
+    // Calls from several threads are serialized, one run at a time; calling
+    // run() from inside a task deadlocks.
+    void run(std::span<const double> costs, const std::function<void(size_t, unsigned)>& task);
+
+    // Witness stream of worker `index`; far above the streams handed out to
+    // other threads in first-use order
+    static uint64_t worker_stream(unsigned index) { return (uint64_t(1) << 32) + index; }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    void worker_loop(unsigned index);
+    // Next task for `worker`: its own front first, then another worker's back
+    bool pop(unsigned worker, size_t& task);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::mutex run_mutex_;  // held for the whole of run()
+    std::mutex mutex_;
+    std::condition_variable start_;
+    std::condition_variable done_;
+    const std::function<void(size_t, unsigned)>* task_ = nullptr;
+    uint64_t generation_ = 0;
+    unsigned active_ = 0;  // workers still inside the current run
+    bool stop_ = false;
+};
+
+// Pool shared by the batch functions, created on first use
+ThreadPool& default_thread_pool();
+
+#endif
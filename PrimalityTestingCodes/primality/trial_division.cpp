@@ -0,0 +1,127 @@
+#include "primality/trial_division.h"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cmath>
+#include <stdexcept>
+#include <gmpxx.h>
+
+namespace {
+
+constexpr std::array<unsigned, 4> wheel_primes = {2, 3, 5, 7};
+
+// Gaps between the residues prime to 210, starting from 11
+constexpr std::array<unsigned char, 48> make_wheel_gaps() {
+    std::array<unsigned, 49> residues{};
+    size_t count = 0;
+    for (unsigned r = 11; r <= 11 + 210; ++r)
+        if (r % 2 && r % 3 && r % 5 && r % 7)
+            residues[count++] = r;
+    std::array<unsigned char, 48> gaps{};
+    for (size_t i = 0; i < 48; ++i)
+        gaps[i] = static_cast<unsigned char>(residues[i + 1] - residues[i]);
+    return gaps;
+}
+
+constexpr auto wheel_gaps = make_wheel_gaps();
+
+uint64_t isqrt(uint64_t x) {
+    uint64_t r = static_cast<uint64_t>(std::sqrt(static_cast<double>(x)));
+    while (r > UINT32_MAX || r * r > x)
+        --r;
+    while (r < UINT32_MAX && (r + 1) * (r + 1) <= x)
+        ++r;
+    return r;
+}
+
+// Smallest wheel divisor d <= bound of n, or 0; the loop is unrolled over one
+// turn of the wheel so the gaps are constants
+template <typename Word>
+Word wheel_factor(Word n, uint64_t bound) {
+    uint64_t d = 11;
+    while (d + 210 <= bound) {
+        for (unsigned char gap : wheel_gaps) {
+            if (n % static_cast<Word>(d) == 0)
+                return static_cast<Word>(d);
+            d += gap;
+        }
+    }
+    for (size_t i = 0; d <= bound; d += wheel_gaps[i], i = (i + 1) % wheel_gaps.size())
+        if (n % static_cast<Word>(d) == 0)
+            return static_cast<Word>(d);
+    return 0;
+}
+
+}  // namespace
+
+uint64_t trial_factor_u64(uint64_t n, uint64_t limit) {
+    if (n < 2)
+        return 0;
+    for (unsigned p : wheel_primes) {
+        if (p > limit)
+            return 0;
+        if (n % p == 0)
+            return p;
+    }
+
+    uint64_t bound = std::min(limit, isqrt(n));
+    uint64_t factor = n >> 32 == 0 ? wheel_factor<uint32_t>(static_cast<uint32_t>(n), bound)
+                                   : wheel_factor<uint64_t>(n, bound);
+    if (factor != 0)
+        return factor;
+    // No factor up to sqrt(n) makes n itself the smallest one
+    return n <= limit ? n : 0;
+}
+
+unsigned long trial_factor(const mpz_t n, unsigned long limit) {
+    if (mpz_fits_ulong_p(n))
+        return trial_factor_u64(mpz_get_ui(n), limit);
+
+    unsigned long residue = mpz_tdiv_ui(n, 210);
+    for (unsigned p : wheel_primes) {
+        if (p > limit)
+            return 0;
+        if (residue % p == 0)
+            return p;
+    }
+
+    mpz_class root;
+    mpz_sqrt(root.get_mpz_t(), n);
+    unsigned long bound = mpz_fits_ulong_p(root.get_mpz_t()) ? std::min(limit, mpz_get_ui(root.get_mpz_t())) : limit;
+
+    // n is above every divisor tried, so a factor found is never n itself
+    std::array<unsigned long, 16> run;
+    unsigned long d = 11;
+    size_t gap = 0;
+    bool more = true;
+    while (more && d <= bound) {
+        size_t count = 0;
+        unsigned long product = 1, next;
+        while (count < run.size() && d <= bound && !__builtin_mul_overflow(product, d, &next)) {
+            product = next;
+            run[count++] = d;
+            if (__builtin_add_overflow(d, wheel_gaps[gap], &d)) {
+                more = false;  // the wheel ran past the top of the word
+                break;
+            }
+            gap = (gap + 1) % wheel_gaps.size();
+        }
+        unsigned long r = mpz_tdiv_ui(n, product);
+        for (size_t i = 0; i < count; ++i)
+            if (r % run[i] == 0)
+                return run[i];
+    }
+    return 0;
+}
+
+bool is_prime_trial_division(const mpz_t n) {
+    if (mpz_cmp_ui(n, 2) < 0)
+        return false;
+    // Above 2^128 floor(sqrt(n)) no longer fits in the word trial_factor takes
+    if (mpz_sizeinbase(n, 2) > 128)
+        throw std::invalid_argument("is_prime_trial_division: n must be below 2^128");
+    mpz_class root;
+    mpz_sqrt(root.get_mpz_t(), n);
+    return trial_factor(n, mpz_get_ui(root.get_mpz_t())) == 0;
+}
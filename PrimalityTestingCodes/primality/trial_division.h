@@ -0,0 +1,21 @@
+#ifndef PRIMALITY_TRIAL_DIVISION_H
+#define PRIMALITY_TRIAL_DIVISION_H
+
+#include <cstdint>
+#include <gmp.h>
+
+// Deterministic trial division over a mod-210 wheel: after 2, 3, 5 and 7 only
+// the 48 residues prime to 210 in each block of 210 are tried, 23% of the
+// integers. An n that fits in a word is divided natively (in 32 bits when it
+// fits there); a larger one packs runs of consecutive divisors into one word,
+// takes a single mpz_tdiv_ui by their product and splits the remainder.
+
+// Smallest prime factor of n if it is at most limit, otherwise 0 (also for n < 2)
+uint64_t trial_factor_u64(uint64_t n, uint64_t limit);
+unsigned long trial_factor(const mpz_t n, unsigned long limit);
+
+// Primality by trial division up to floor(sqrt(n)); n must be below 2^128 so
+// that the bound fits in a word, and larger n throw std::invalid_argument
+bool is_prime_trial_division(const mpz_t n);
+
+#endif
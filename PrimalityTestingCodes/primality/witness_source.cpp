@@ -0,0 +1,178 @@
+#include "primality/witness_source.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <random>
+#include <thread>
+
+uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+MersenneTwisterSource::MersenneTwisterSource(uint64_t seed) {
+    gmp_randinit_mt(state_);
+    mpz_init(bound_);
+    this->seed(seed);
+}
+
+MersenneTwisterSource::~MersenneTwisterSource() {
+    gmp_randclear(state_);
+    mpz_clear(bound_);
+}
+
+void MersenneTwisterSource::next(mpz_t a, const mpz_t n) {
+    mpz_sub_ui(bound_, n, 3);
+    mpz_urandomm(a, state_, bound_);
+    mpz_add_ui(a, a, 2);
+}
+
+void MersenneTwisterSource::seed(uint64_t seed) {
+    gmp_randseed_ui(state_, static_cast<unsigned long>(seed));
+}
+
+Xoshiro256Source::Xoshiro256Source(uint64_t seed) {
+    mpz_init(bound_);
+    this->seed(seed);
+}
+
+Xoshiro256Source::~Xoshiro256Source() {
+    mpz_clear(bound_);
+}
+
+void Xoshiro256Source::seed(uint64_t seed) {
+    for (uint64_t& word : s_)
+        word = splitmix64(seed);
+}
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+uint64_t Xoshiro256Source::next_u64() {
+    uint64_t result = rotl(s_[1] * 5, 7) * 9;
+    uint64_t t = s_[1] << 17;
+
+    s_[2] ^= s_[0];
+    s_[3] ^= s_[1];
+    s_[1] ^= s_[2];
+    s_[0] ^= s_[3];
+    s_[2] ^= t;
+    s_[3] = rotl(s_[3], 45);
+
+    return result;
+}
+
+uint64_t Xoshiro256Source::uniform(uint64_t range) {
+    // Lemire's multiply-and-reject
+    unsigned __int128 m = static_cast<unsigned __int128>(next_u64()) * range;
+    uint64_t low = static_cast<uint64_t>(m);
+    if (low < range) {
+        uint64_t threshold = -range % range;
+        while (low < threshold) {
+            m = static_cast<unsigned __int128>(next_u64()) * range;
+            low = static_cast<uint64_t>(m);
+        }
+    }
+    return static_cast<uint64_t>(m >> 64);
+}
+
+void Xoshiro256Source::next(mpz_t a, const mpz_t n) {
+    if (mpz_sizeinbase(n, 2) <= 64) {
+        uint64_t n64 = mpz_get_ui(n);
+        mpz_set_ui(a, 2 + uniform(n64 - 3));
+        return;
+    }
+
+    // Draw limbs below the top bit of n and reject values outside [2, n - 2]
+    mpz_sub_ui(bound_, n, 2);
+    size_t size = mpz_size(n);
+    mp_bitcnt_t top_bits = mpz_sizeinbase(n, 2) - (size - 1) * GMP_NUMB_BITS;
+    mp_limb_t top_mask = top_bits >= GMP_NUMB_BITS ? GMP_NUMB_MASK : (mp_limb_t(1) << top_bits) - 1;
+
+    do {
+        mp_limb_t* limbs = mpz_limbs_write(a, size);
+        for (size_t i = 0; i < size; ++i)
+            limbs[i] = static_cast<mp_limb_t>(next_u64()) & GMP_NUMB_MASK;
+        limbs[size - 1] &= top_mask;
+        mpz_limbs_finish(a, size);
+    } while (mpz_cmp(a, bound_) > 0 || mpz_cmp_ui(a, 2) < 0);
+}
+
+namespace {
+
+std::atomic<WitnessGenerator> generator_kind{WitnessGenerator::MersenneTwister};
+std::atomic<bool> seeded_mode{false};
+std::atomic<uint64_t> base_seed{0};
+// Bumped on every configuration change so thread sources rebuild lazily
+std::atomic<unsigned> config_epoch{1};
+std::atomic<uint64_t> next_stream{0};
+
+struct ThreadWitnessState {
+    unsigned epoch = 0;
+    uint64_t stream = next_stream.fetch_add(1, std::memory_order_relaxed);
+    std::unique_ptr<WitnessSource> source;
+};
+
+thread_local ThreadWitnessState thread_state;
+
+uint64_t entropy_seed() {
+    std::random_device device;
+    uint64_t seed = (static_cast<uint64_t>(device()) << 32) ^ device();
+    seed ^= std::chrono::steady_clock::now().time_since_epoch().count();
+    seed ^= std::hash<std::thread::id>()(std::this_thread::get_id());
+    return seed;
+}
+
+uint64_t stream_seed(uint64_t stream) {
+    if (!seeded_mode.load(std::memory_order_acquire))
+        return entropy_seed();
+    uint64_t state = base_seed.load(std::memory_order_relaxed) ^ (stream * 0xd1b54a32d192ed03ull);
+    return splitmix64(state);
+}
+
+void rebuild(ThreadWitnessState& state) {
+    if (generator_kind.load(std::memory_order_relaxed) == WitnessGenerator::Xoshiro256)
+        state.source = std::make_unique<Xoshiro256Source>();
+    else
+        state.source = std::make_unique<MersenneTwisterSource>();
+    state.source->seed(stream_seed(state.stream));
+    state.epoch = config_epoch.load(std::memory_order_acquire);
+}
+
+}  // namespace
+
+void set_witness_generator(WitnessGenerator generator) {
+    generator_kind.store(generator, std::memory_order_relaxed);
+    config_epoch.fetch_add(1, std::memory_order_release);
+}
+
+WitnessGenerator witness_generator() {
+    return generator_kind.load(std::memory_order_relaxed);
+}
+
+void set_witness_seed(uint64_t seed) {
+    base_seed.store(seed, std::memory_order_relaxed);
+    seeded_mode.store(true, std::memory_order_release);
+    config_epoch.fetch_add(1, std::memory_order_release);
+}
+
+void clear_witness_seed() {
+    seeded_mode.store(false, std::memory_order_release);
+    config_epoch.fetch_add(1, std::memory_order_release);
+}
+
+WitnessSource& thread_witness_source() {
+    if (thread_state.epoch != config_epoch.load(std::memory_order_acquire))
+        rebuild(thread_state);
+    return *thread_state.source;
+}
+
+void seed_thread_witness_source(uint64_t stream) {
+    thread_state.stream = stream;
+    rebuild(thread_state);
+}
@@ -0,0 +1,76 @@
+#ifndef PRIMALITY_WITNESS_SOURCE_H
+#define PRIMALITY_WITNESS_SOURCE_H
+
+#include <cstdint>
+#include <gmp.h>
+
+// Supplies the random bases used by the Miller-Rabin rounds
+class WitnessSource {
+public:
+    virtual ~WitnessSource() = default;
+
+    // Sets a to a base drawn uniformly from [2, n - 2]; n must be odd and > 3
+    virtual void next(mpz_t a, const mpz_t n) = 0;
+    virtual void seed(uint64_t seed) = 0;
+};
+
+// GMP's Mersenne Twister, the generator the experiments were first run with
+class MersenneTwisterSource : public WitnessSource {
+public:
+    explicit MersenneTwisterSource(uint64_t seed = 0);
+    ~MersenneTwisterSource() override;
+
+    MersenneTwisterSource(const MersenneTwisterSource&) = delete;
+    MersenneTwisterSource& operator=(const MersenneTwisterSource&) = delete;
+
+    void next(mpz_t a, const mpz_t n) override;
+    void seed(uint64_t seed) override;
+
+private:
+    gmp_randstate_t state_;
+    mpz_t bound_;
+};
+
+// xoshiro256** with a single-word path when n < 2^64 and limb-wise
+// rejection sampling above that
+class Xoshiro256Source : public WitnessSource {
+public:
+    explicit Xoshiro256Source(uint64_t seed = 0);
+    ~Xoshiro256Source() override;
+
+    Xoshiro256Source(const Xoshiro256Source&) = delete;
+    Xoshiro256Source& operator=(const Xoshiro256Source&) = delete;
+
+    void next(mpz_t a, const mpz_t n) override;
+    void seed(uint64_t seed) override;
+
+    uint64_t next_u64();
+    // Uniform value in [0, range), range > 0
+    uint64_t uniform(uint64_t range);
+
+private:
+    uint64_t s_[4];
+    mpz_t bound_;
+};
+
+enum class WitnessGenerator { MersenneTwister, Xoshiro256 };
+
+// Generator behind thread_witness_source(); existing thread sources are rebuilt on next use
+void set_witness_generator(WitnessGenerator generator);
+WitnessGenerator witness_generator();
+
+// Deterministic-seed mode: thread sources are seeded from `seed` and their stream
+// number instead of std::random_device, so benchmark runs can be reproduced
+void set_witness_seed(uint64_t seed);
+void clear_witness_seed();
+
+// Per-thread source used by is_probable_prime. Threads get stream numbers in the
+// order they first draw; worker pools should call seed_thread_witness_source with
+// the worker index so streams do not depend on scheduling.
+WitnessSource& thread_witness_source();
+void seed_thread_witness_source(uint64_t stream);
+
+// SplitMix64 step, used to expand seeds
+uint64_t splitmix64(uint64_t& state);
+
+#endif
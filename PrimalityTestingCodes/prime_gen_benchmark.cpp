@@ -0,0 +1,137 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <gmp.h>
+#include <gmpxx.h>
+#include <fstream>
+#include <functional>
+#include <vector>
+
+#include "primality/primality.h"
+
+int main() {
+    gmp_randstate_t rand_state;
+    gmp_randinit_mt(rand_state);
+    gmp_randseed_ui(rand_state, std::chrono::high_resolution_clock::now().time_since_epoch().count());
+
+    const std::vector<mp_bitcnt_t> bit_sizes = {256, 512, 1024, 2048};
+    // Primes generated per size and method; fewer for the slow sizes
+    auto primes_per_size = [](mp_bitcnt_t bits) { return bits >= 2048 ? 10 : bits >= 1024 ? 30 : 100; };
+
+    struct Generator {
+        std::string name;
+        std::function<void(mpz_t, mp_bitcnt_t)> generate;
+    };
+    // Rejection sampling draws a fresh odd number of the right size until one
+    // passes, as the notebooks and the iteration experiments do
+    auto draw_odd = [&](mpz_t n, mp_bitcnt_t bits) {
+        mpz_urandomb(n, rand_state, bits);
+        mpz_setbit(n, bits - 1);
+        mpz_setbit(n, 0);
+    };
+    // Plain Miller-Rabin on every draw, like the Python generator of the RSA notebook
+    MillerRabinContext unscreened;
+    unscreened.prefilter().set_limits(0, 0);
+    const std::vector<Generator> generators = {
+        {"Rejection (Miller-Rabin only)",
+         [&](mpz_t n, mp_bitcnt_t bits) {
+             do {
+                 draw_odd(n, bits);
+             } while (!unscreened.is_probable_prime(n, -1, thread_witness_source()));
+         }},
+        {"Rejection (mpz_probab_prime_p)",
+         [&](mpz_t n, mp_bitcnt_t bits) {
+             int k = default_rounds(bits * 3 / 10);
+             do {
+                 draw_odd(n, bits);
+             } while (!mpz_probab_prime_p(n, k));
+         }},
+        {"Rejection (is_probable_prime)",
+         [&](mpz_t n, mp_bitcnt_t bits) {
+             do {
+                 draw_odd(n, bits);
+             } while (!is_probable_prime(n));
+         }},
+        {"mpz_nextprime from random start",
+         [&](mpz_t n, mp_bitcnt_t bits) {
+             draw_odd(n, bits);
+             mpz_nextprime(n, n);
+         }},
+        {"random_prime", [&](mpz_t n, mp_bitcnt_t bits) { random_prime(n, bits, rand_state); }},
+    };
+
+    std::ofstream file("Primality_Testing/data/prime_gen_benchmark.csv");
+    if (file.is_open())
+        file << "Bits,Generator,Time\n";
+    else
+        std::cerr << "Unable to open file for writing.\n";
+
+    mpz_class p;
+    for (mp_bitcnt_t bits : bit_sizes) {
+        int count = primes_per_size(bits);
+        std::cout << "Bits: " << bits << " (" << count << " primes)\n";
+        for (const auto& generator : generators) {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < count; ++i)
+                generator.generate(p.get_mpz_t(), bits);
+            auto end = std::chrono::high_resolution_clock::now();
+            double avg = std::chrono::duration<double>(end - start).count() / count;
+
+            std::cout << "  " << generator.name << ": " << avg << " seconds per prime\n";
+            if (file.is_open())
+                file << bits << "," << generator.name << "," << avg << "\n";
+        }
+        std::cout << "\n";
+    }
+
+    // Safe primes p = 2q + 1: drawing prime q and testing 2q + 1 independently,
+    // against the joint sieve of q and 2q + 1
+    const std::vector<mp_bitcnt_t> safe_bit_sizes = {256, 512, 1024};
+    // The independent search needs hundreds of primes q per safe prime
+    const mp_bitcnt_t independent_bits = 512;
+    auto safe_primes_per_size = [](mp_bitcnt_t bits) { return bits >= 1024 ? 3 : bits >= 512 ? 5 : 10; };
+    if (file.is_open())
+        file << "\nBits,Safe Prime Generator,Time,Candidates Per Second\n";
+
+    mpz_class q;
+    for (mp_bitcnt_t bits : safe_bit_sizes) {
+        int count = safe_primes_per_size(bits);
+        std::cout << "Safe primes, bits: " << bits << " (" << count << " primes)\n";
+
+        if (bits <= independent_bits) {
+            unsigned long tried = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < count; ++i) {
+                do {
+                    random_prime(q.get_mpz_t(), bits - 1, rand_state);
+                    p = 2 * q + 1;
+                    ++tried;
+                } while (!is_probable_prime(p.get_mpz_t()));
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            double avg = std::chrono::duration<double>(end - start).count() / count;
+            std::cout << "  Independent q, then 2q + 1: " << avg << " seconds per prime (" << tried << " primes q)\n";
+            if (file.is_open())
+                file << bits << ",Independent," << avg << ",\n";
+        }
+
+        PrimeSearchStats total, stats;
+        for (int i = 0; i < count; ++i) {
+            random_safe_prime(p.get_mpz_t(), bits, rand_state, -1, &stats);
+            total.candidates += stats.candidates;
+            total.sieve_survivors += stats.sieve_survivors;
+            total.fermat_passes += stats.fermat_passes;
+            total.seconds += stats.seconds;
+        }
+        double avg = total.seconds / count;
+        std::cout << "  Joint sieve (random_safe_prime): " << avg << " seconds per prime, "
+                  << total.candidates_per_second() << " candidates per second [" << total.candidates
+                  << " candidates, " << total.sieve_survivors << " survivors, " << total.fermat_passes
+                  << " Fermat passes]\n\n";
+        if (file.is_open())
+            file << bits << ",Joint sieve," << avg << "," << total.candidates_per_second() << "\n";
+    }
+
+    gmp_randclear(rand_state);
+    return 0;
+}
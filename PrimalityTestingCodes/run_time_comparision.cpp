@@ -10,143 +10,7 @@
 #include <map>
 #include <cmath>
 
-// Perform (base^exp) % mod using GMP
-void mod_exp(mpz_t result, const mpz_t base, const mpz_t exp, const mpz_t mod) {
-    mpz_powm(result, base, exp, mod);
-}
-
-// Returns true if n passes one Miller-Rabin test with base a
-bool miller_test(const mpz_t n, const mpz_t d, const mpz_t a) {
-    mpz_t x;
-    mpz_init(x);
-    mod_exp(x, a, d, n);
-
-    mpz_t n_minus_1;
-    mpz_init(n_minus_1);
-    mpz_sub_ui(n_minus_1, n, 1);
-
-    if (mpz_cmp_ui(x, 1) == 0 || mpz_cmp(x, n_minus_1) == 0) {
-        mpz_clear(x);
-        // mpz_clear(n_minus_1);
-        return true;
-    }
-
-    mpz_t temp_d;
-    mpz_init_set(temp_d, d);
-
-    while (mpz_cmp(temp_d, n) < 0) {
-        mpz_mul_ui(temp_d, temp_d, 2);
-        mod_exp(x, a, temp_d, n);
-
-        if (mpz_cmp_ui(x, 1) == 0) {
-            mpz_clear(x);
-            mpz_clear(temp_d);
-            return false;
-        }
-
-        if (mpz_cmp(x, n_minus_1) == 0) {
-            mpz_clear(x);
-            mpz_clear(temp_d);
-            return true;
-        }
-    }
-
-    mpz_clear(x);
-    mpz_clear(temp_d);
-    mpz_clear(n_minus_1);
-    return false;
-}
-
-// Custom Miller-Rabin with log-log number of rounds
-bool is_prime_miller_rabin(const mpz_t n, int k = -1) {
-    size_t num_digits = mpz_sizeinbase(n, 10);
-    if (k == -1) {
-        double loglog = std::log2(static_cast<double>(num_digits));
-        k = std::max(5, 2 * static_cast<int>(std::ceil(loglog)));
-    }
-
-    if (mpz_cmp_ui(n, 2) == 0 || mpz_cmp_ui(n, 3) == 0)
-        return true;
-    if (mpz_cmp_ui(n, 1) <= 0 || mpz_even_p(n))
-        return false;
-
-    mpz_t d;
-    mpz_init_set(d, n);
-    mpz_sub_ui(d, d, 1);  // d = n - 1
-
-    while (mpz_even_p(d))
-        mpz_divexact_ui(d, d, 2);
-
-    gmp_randstate_t state;
-    gmp_randinit_mt(state);
-    gmp_randseed_ui(state, std::time(nullptr));
-
-    mpz_t a;
-    mpz_init(a);
-
-    for (int i = 0; i < k; ++i) {
-        mpz_sub_ui(a, n, 3);
-        mpz_urandomm(a, state, a);
-        mpz_add_ui(a, a, 2);
-
-        if (!miller_test(n, d, a)) {
-            mpz_clear(d);
-            mpz_clear(a);
-            gmp_randclear(state);
-            return false;
-        }
-    }
-
-    mpz_clear(d);
-    mpz_clear(a);
-    gmp_randclear(state);
-    return true;
-}
-
-bool is_prime_deter(mpz_t n) {
-    mpz_t i, sqrt_n, rem;
-    mpz_inits(i, sqrt_n, rem, NULL);
-
-    // Handle edge cases
-    if (mpz_cmp_ui(n, 2) < 0) {
-        mpz_clears(i, sqrt_n, rem, NULL);
-        return false;
-    }
-    if (mpz_cmp_ui(n, 2) == 0) {
-        mpz_clears(i, sqrt_n, rem, NULL);
-        return true;
-    }
-
-    // Compute sqrt(n)
-    mpz_sqrt(sqrt_n, n);
-
-    // Check for divisibility from 2 to sqrt(n)
-    for (mpz_set_ui(i, 2); mpz_cmp(i, sqrt_n) <= 0; mpz_add_ui(i, i, 1)) {
-        mpz_mod(rem, n, i);
-        if (mpz_cmp_ui(rem, 0) == 0) {
-            mpz_clears(i, sqrt_n, rem, NULL);
-            return false; // divisible by i
-        }
-    }
-
-    mpz_clears(i, sqrt_n, rem, NULL);
-    return true; // no divisor found
-}
-
-// Generate a random number with `num_digits` digits.
-void generate_random_mpz(mpz_t result, gmp_randstate_t state, size_t num_digits) {
-    mpz_t lower, upper;
-    mpz_inits(lower, upper, NULL);
-
-    mpz_ui_pow_ui(lower, 10, num_digits - 1); // 10^(d-1)
-    mpz_ui_pow_ui(upper, 10, num_digits);     // 10^d
-    mpz_sub(upper, upper, lower);             // Range = 10^d - 10^(d-1)
-
-    mpz_urandomm(result, state, upper);       // result in [0, range)
-    mpz_add(result, result, lower);           // result in [10^(d-1), 10^d)
-
-    mpz_clears(lower, upper, NULL);
-}
+#include "primality/primality.h"
 
 int main() {
     gmp_randstate_t rand_state;
@@ -156,12 +20,17 @@ int main() {
     int num_trials = 5;
     const std::vector<long long> digit_sizes = {10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20}; // Customize as needed
     std::map<long long, double> random_times;
+    std::map<long long, double> gmp_times;
+    std::map<long long, double> bpsw_times;
     std::map<long long, double> deter_times;
 
     for (int digits : digit_sizes) {
         double total_custom = 0.0;
         double total_gmp = 0.0;
         double total_deter = 0.0;
+        double total_bpsw = 0.0;
+        int mismatches = 0;
+        int deter_mismatches = 0;
         num_trials = 50;
         for (int t = 0; t < num_trials; ++t) {
             mpz_t num;
@@ -170,18 +39,17 @@ int main() {
 
             // Custom Miller-Rabin Benchmark
             auto start_custom = std::chrono::high_resolution_clock::now();
-            bool result_custom = is_prime_miller_rabin(num);
+            bool result_custom = is_probable_prime(num);
             auto end_custom = std::chrono::high_resolution_clock::now();
             total_custom += std::chrono::duration<double>(end_custom - start_custom).count();
 
             // GMP Benchmark
             size_t num_digits = mpz_sizeinbase(num, 10);
-            double loglog = std::log2(num_digits);
-            int k = std::max(5, 2 * static_cast<int>(std::ceil(loglog)));
+            int k = default_rounds(num_digits);
 
-            // deterministic test
+            // Deterministic baseline: trial division over the mod-210 wheel
             auto start_deter = std::chrono::high_resolution_clock::now();
-            bool result_deter = is_prime_deter(num);
+            bool result_deter = is_prime_trial_division(num);
             auto end_deter = std::chrono::high_resolution_clock::now();
             total_deter += std::chrono::duration<double>(end_deter - start_deter).count();
 
@@ -191,22 +59,40 @@ int main() {
             auto end_gmp = std::chrono::high_resolution_clock::now();
             total_gmp += std::chrono::duration<double>(end_gmp - start_gmp).count();
 
+            // Baillie-PSW Benchmark
+            auto start_bpsw = std::chrono::high_resolution_clock::now();
+            bool result_bpsw = is_prime(num, TestMode::BailliePSW);
+            auto end_bpsw = std::chrono::high_resolution_clock::now();
+            total_bpsw += std::chrono::duration<double>(end_bpsw - start_bpsw).count();
+            if (result_bpsw != (result_gmp != 0))
+                ++mismatches;
+            if (result_deter != (result_gmp != 0))
+                ++deter_mismatches;
+
             mpz_clear(num);
         }
 
         std::cout << "Digits: " << digits << "\n";
         std::cout << "  Avg [Custom Miller-Rabin]: " << (total_custom / num_trials) << " seconds\n";
-        std::cout << "  Avg [GMP Built-in]        : " << (total_gmp / num_trials) << " seconds\n\n";
-        std::cout << "  Avg [Deterministic]       : " << (total_deter / num_trials) << " seconds\n\n";
+        std::cout << "  Avg [GMP Built-in]        : " << (total_gmp / num_trials) << " seconds\n";
+        std::cout << "  Avg [Baillie-PSW]         : " << (total_bpsw / num_trials) << " seconds\n";
+        std::cout << "  Avg [Deterministic]       : " << (total_deter / num_trials) << " seconds\n";
+        if (mismatches != 0)
+            std::cout << "  BPSW/GMP disagreements    : " << mismatches << "\n";
+        if (deter_mismatches != 0)
+            std::cout << "  Trial division/GMP disagreements: " << deter_mismatches << "\n";
+        std::cout << "\n";
         deter_times[digits] = total_deter / num_trials;
         random_times[digits] = total_custom / num_trials;
+        gmp_times[digits] = total_gmp / num_trials;
+        bpsw_times[digits] = total_bpsw / num_trials;
     }
     // Print to file
     std::ofstream file("Primality_Testing/data/miller_rabin_comparision.csv");
     if (file.is_open()) {
-        file << "Digits,Random Time,Deterministic Time\n";
+        file << "Digits,Random Time,Deterministic Time,GMP Time,BPSW Time\n";
         for (const auto& size : digit_sizes) {
-            file << size << "," << random_times[size] << "," << deter_times[size] << "\n";
+            file << size << "," << random_times[size] << "," << deter_times[size] << "," << gmp_times[size] << "," << bpsw_times[size] << "\n";
         }
         file.close();
     } else {
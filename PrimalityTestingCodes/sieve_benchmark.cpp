@@ -0,0 +1,67 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <gmp.h>
+#include <gmpxx.h>
+#include <fstream>
+#include <vector>
+
+#include "primality/primality.h"
+
+int main(int argc, char* argv[]) {
+    // Largest pool to try; defaults to every core
+    unsigned max_threads = argc > 1 ? std::stoul(argv[1]) : std::thread::hardware_concurrency();
+    if (max_threads == 0)
+        max_threads = 1;
+
+    const std::vector<uint64_t> interval_starts = {1000000ULL, 1000000000ULL, 1000000000000ULL,
+                                                   1000000000000000ULL, 1000000000000000000ULL};
+    const uint64_t interval_length = 10000000;
+    // Per-number testing is timed on this many numbers from the start of each interval
+    const uint64_t sampled_length = 100000;
+
+    std::vector<unsigned> thread_counts;
+    for (unsigned threads = 1; threads < max_threads; threads *= 2)
+        thread_counts.push_back(threads);
+    thread_counts.push_back(max_threads);
+
+    std::ofstream file("Primality_Testing/data/sieve_benchmark.csv");
+    if (file.is_open())
+        file << "Start,Length,Method,Threads,Time,Primes\n";
+    else
+        std::cerr << "Unable to open file for writing.\n";
+
+    for (uint64_t lo : interval_starts) {
+        uint64_t hi = lo + interval_length;
+        std::cout << "Interval [" << lo << ", " << hi << ")\n";
+
+        for (unsigned threads : thread_counts) {
+            ThreadPool pool(threads);
+            auto start = std::chrono::high_resolution_clock::now();
+            uint64_t count = count_primes(lo, hi, &pool);
+            auto end = std::chrono::high_resolution_clock::now();
+            double elapsed = std::chrono::duration<double>(end - start).count();
+            std::cout << "  Segmented sieve, " << threads << " thread(s): " << elapsed << " seconds (" << count
+                      << " primes)\n";
+            if (file.is_open())
+                file << lo << "," << interval_length << ",Sieve," << threads << "," << elapsed << "," << count << "\n";
+        }
+
+        // The per-number alternative, which GMP makes exact below 2^64
+        mpz_class n;
+        uint64_t count = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (uint64_t x = lo; x < lo + sampled_length; ++x) {
+            mpz_set_ui(n.get_mpz_t(), x);
+            count += mpz_probab_prime_p(n.get_mpz_t(), 25) != 0;
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double elapsed = std::chrono::duration<double>(end - start).count() * interval_length / sampled_length;
+        std::cout << "  mpz_probab_prime_p per number (projected): " << elapsed << " seconds\n";
+        std::cout << "  Sieve on the same " << sampled_length << " numbers: " << count_primes(lo, lo + sampled_length)
+                  << " primes, per-number: " << count << "\n\n";
+        if (file.is_open())
+            file << lo << "," << interval_length << ",mpz_probab_prime_p,1," << elapsed << ",\n";
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "primality/primality.h"
+
+int main() {
+    std::mt19937_64 rng(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+
+    const std::vector<int> bit_sizes = {32, 40, 48, 56, 62, 64};
+    const size_t num_candidates = 1 << 20;
+    const std::vector<std::pair<U64BatchKernel, std::string>> kernels = {
+        {U64BatchKernel::Scalar, "Scalar batch"},
+        {U64BatchKernel::Avx2, "AVX2 batch"},
+        {U64BatchKernel::Avx512Ifma, "AVX-512 IFMA batch"},
+    };
+    // Per bit size and input set: the is_prime_u64 loop, then each kernel
+    std::map<std::pair<int, int>, std::vector<double>> times;
+
+    for (int bits : bit_sizes) {
+        for (int primes_only = 0; primes_only < 2; ++primes_only) {
+            // Odd numbers of exactly `bits` bits, or primes so that every base is run
+            std::vector<uint64_t> candidates;
+            while (candidates.size() < num_candidates) {
+                uint64_t n = rng() >> (64 - bits) | 1 | (uint64_t(1) << (bits - 1));
+                if (!primes_only || is_prime_u64(n))
+                    candidates.push_back(n);
+            }
+
+            std::vector<unsigned char> expected(num_candidates), verdicts(num_candidates);
+            auto start_loop = std::chrono::high_resolution_clock::now();
+            for (size_t i = 0; i < num_candidates; ++i)
+                expected[i] = is_prime_u64(candidates[i]);
+            auto end_loop = std::chrono::high_resolution_clock::now();
+            double total_loop = std::chrono::duration<double>(end_loop - start_loop).count();
+
+            std::cout << "Bits: " << bits << (primes_only ? " (primes)" : " (odd numbers)") << "\n";
+            std::cout << "  [is_prime_u64 loop]        : " << (total_loop / num_candidates * 1e9) << " ns per number\n";
+            auto& row = times[{bits, primes_only}];
+            row.push_back(total_loop / num_candidates);
+
+            for (const auto& [kernel, name] : kernels) {
+                if (!u64_batch_kernel_supported(kernel)) {
+                    std::cout << "  [" << name << "] not supported on this CPU\n";
+                    row.push_back(0.0);
+                    continue;
+                }
+                auto start = std::chrono::high_resolution_clock::now();
+                is_prime_u64_batch(candidates, verdicts, kernel);
+                auto end = std::chrono::high_resolution_clock::now();
+                double total = std::chrono::duration<double>(end - start).count();
+
+                size_t mismatches = 0;
+                for (size_t i = 0; i < num_candidates; ++i)
+                    mismatches += verdicts[i] != expected[i];
+                std::cout << "  [" << name << "]" << std::string(25 - name.size(), ' ') << ": "
+                          << (total / num_candidates * 1e9) << " ns per number, speedup " << (total_loop / total)
+                          << "x\n";
+                if (mismatches != 0)
+                    std::cout << "  Mismatched verdicts        : " << mismatches << "\n";
+                row.push_back(total / num_candidates);
+            }
+            std::cout << "\n";
+        }
+    }
+    // Print to file
+    std::ofstream file("Primality_Testing/data/u64_batch_benchmark.csv");
+    if (file.is_open()) {
+        file << "Bits,Primes Only,Loop Time,Scalar Batch Time,AVX2 Time,AVX-512 IFMA Time\n";
+        for (const auto& [key, row] : times) {
+            file << key.first << "," << key.second;
+            for (double t : row)
+                file << "," << t;
+            file << "\n";
+        }
+        file.close();
+    } else {
+        std::cerr << "Unable to open file for writing.\n";
+    }
+
+    return 0;
+}